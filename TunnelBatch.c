@@ -0,0 +1,233 @@
+#include "TunnelBatch.h"
+#include "TunnelEncoding.h"
+#include "TunnelProgress.h"
+#include "TunnelReduction.h"
+#include "TunnelTrace.h"
+#include "TunnelView.h"
+#include "Z3Tools.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+struct tn_batch_s
+{
+    Z3_context ctx;
+    TunnelNetwork network;
+    tn_view view;
+    int max_length;
+    int *capacities;     // une par arête, dans l'ordre du CSR de la vue ; négatif = pas de limite
+    long long *reserved; // somme des bandes passantes des demandes pouvant utiliser l'arête
+    Z3_solver solver;
+    Z3_model model;
+    tn_demand *demands;
+    int num_demands;
+    int max_demands;
+};
+
+// La demande i de longueur length utilise sa propre copie du chemin (la copie 0 reste celle de tn_reduction)
+static int demand_copy(const tn_batch batch, int demand, int length)
+{
+    return 1 + demand * batch->max_length + length - 1;
+}
+
+// Littéral activant la réduction de longueur length de la demande
+static Z3_ast length_guard(Z3_context ctx, int demand, int length)
+{
+    char name[60];
+    snprintf(name, 60, "[demand %d] length %d", demand, length);
+    return mk_bool_var(ctx, name);
+}
+
+// Variable e_{demand,u,v} : la demande passe par l'arête u -> v
+static Z3_ast edge_use_variable(Z3_context ctx, int demand, int u, int v)
+{
+    char name[80];
+    snprintf(name, 80, "[demand %d] edge %d -> %d", demand, u, v);
+    return mk_bool_var(ctx, name);
+}
+
+tn_batch tn_batch_create(Z3_context ctx, const TunnelNetwork network, int max_length, const int *capacities)
+{
+    tn_batch batch = malloc(sizeof(struct tn_batch_s));
+    batch->ctx = ctx;
+    batch->network = network;
+    batch->view = tn_view_from_network(network);
+    batch->max_length = max_length;
+
+    int num_edges = 0;
+    for (int u = 0; u < tn_view_num_nodes(batch->view); u++)
+    {
+        int num_successors;
+        tn_view_successors(batch->view, u, &num_successors);
+        num_edges += num_successors;
+    }
+    batch->capacities = malloc((num_edges > 0 ? num_edges : 1) * sizeof(int));
+    batch->reserved = calloc(num_edges > 0 ? num_edges : 1, sizeof(long long));
+    for (int e = 0; e < num_edges; e++)
+        batch->capacities[e] = capacities[e];
+
+    batch->solver = Z3_mk_solver(ctx);
+    Z3_solver_inc_ref(ctx, batch->solver);
+    batch->model = NULL;
+    batch->num_demands = 0;
+    batch->max_demands = 16;
+    batch->demands = malloc(batch->max_demands * sizeof(tn_demand));
+    return batch;
+}
+
+void tn_batch_delete(tn_batch batch)
+{
+    if (batch->model != NULL)
+        Z3_model_dec_ref(batch->ctx, batch->model);
+    Z3_solver_dec_ref(batch->ctx, batch->solver);
+    tn_view_delete(batch->view);
+    free(batch->demands);
+    free(batch->reserved);
+    free(batch->capacities);
+    free(batch);
+}
+
+int tn_batch_num_demands(const tn_batch batch)
+{
+    return batch->num_demands;
+}
+
+/**
+ * Relie e_{demand,u,v} aux chemins de la demande : si la longueur length est choisie et que son chemin est en u
+ * à la position pos et en v à la position pos + 1, alors e_{demand,u,v} est vrai. Le sens inverse est inutile,
+ * la contrainte de capacité ne fait que limiter les e à vrai.
+ */
+static void assert_edge_use(tn_batch batch, int demand, int u, int v)
+{
+    Z3_context ctx = batch->ctx;
+    Z3_ast use = edge_use_variable(ctx, demand, u, v);
+
+    for (int length = 1; length <= batch->max_length; length++)
+    {
+        int copy = demand_copy(batch, demand, length);
+        for (int pos = 0; pos < length; pos++)
+        {
+            Z3_ast step[3] = {length_guard(ctx, demand, length), tn_node_at_position(ctx, copy, u, pos, length),
+                              tn_node_at_position(ctx, copy, v, pos + 1, length)};
+            Z3_solver_assert(ctx, batch->solver, Z3_mk_implies(ctx, Z3_mk_and(ctx, 3, step), use));
+        }
+    }
+}
+
+/**
+ * Contrainte de capacité de l'arête u -> v : somme des bandwidth * e_{i,u,v} <= capacité, sur toutes les
+ * demandes déjà ajoutées. Elle implique celle assertée avant l'ajout de la dernière demande, qui reste dans le
+ * solveur sans rien changer.
+ */
+static void assert_capacity(tn_batch batch, int u, int v, int capacity)
+{
+    Z3_context ctx = batch->ctx;
+    Z3_ast *uses = malloc(batch->num_demands * sizeof(Z3_ast));
+    int *bandwidths = malloc(batch->num_demands * sizeof(int));
+    int n = 0;
+
+    for (int i = 0; i < batch->num_demands; i++)
+    {
+        if (batch->demands[i].bandwidth <= 0)
+            continue;
+        uses[n] = edge_use_variable(ctx, i, u, v);
+        bandwidths[n] = batch->demands[i].bandwidth;
+        n++;
+    }
+
+    Z3_solver_assert(ctx, batch->solver, Z3_mk_pble(ctx, n, uses, bandwidths, capacity));
+    free(bandwidths);
+    free(uses);
+}
+
+int tn_batch_add_demand(tn_batch batch, tn_demand demand)
+{
+    Z3_context ctx = batch->ctx;
+    int max_length = batch->max_length;
+
+    if (batch->num_demands == batch->max_demands)
+    {
+        batch->max_demands *= 2;
+        batch->demands = realloc(batch->demands, batch->max_demands * sizeof(tn_demand));
+    }
+    int index = batch->num_demands;
+
+    // Les chemins de la demande, indépendants des autres demandes : tous construits avant d'asserter quoi que ce
+    // soit, pour laisser le lot inchangé si la limite de mémoire arrête l'un d'eux
+    Z3_ast *reductions = malloc((max_length > 0 ? max_length : 1) * sizeof(Z3_ast));
+    Z3_ast *guards = malloc((max_length > 0 ? max_length : 1) * sizeof(Z3_ast));
+    for (int length = 1; length <= max_length; length++)
+    {
+        reductions[length - 1] = tn_reduction_copy(ctx, batch->network, demand_copy(batch, index, length),
+                                                   demand.source, demand.target, length);
+        if (reductions[length - 1] == NULL)
+        {
+            free(guards);
+            free(reductions);
+            return -1;
+        }
+        guards[length - 1] = length_guard(ctx, index, length);
+    }
+    for (int length = 1; length <= max_length; length++)
+        Z3_solver_assert(ctx, batch->solver, Z3_mk_implies(ctx, guards[length - 1], reductions[length - 1]));
+    Z3_solver_assert(ctx, batch->solver, Z3_mk_or(ctx, max_length, guards));
+    free(guards);
+    free(reductions);
+    batch->num_demands++;
+    batch->demands[index] = demand;
+
+    if (demand.bandwidth <= 0)
+        return index;
+
+    // Seules les arêtes que la demande peut saturer reçoivent une nouvelle contrainte de capacité
+    int edge = 0;
+    for (int u = 0; u < tn_view_num_nodes(batch->view); u++)
+    {
+        int num_successors;
+        const int *successors = tn_view_successors(batch->view, u, &num_successors);
+        for (int k = 0; k < num_successors; k++, edge++)
+        {
+            int capacity = batch->capacities[edge];
+            if (capacity < 0)
+                continue;
+
+            assert_edge_use(batch, index, u, successors[k]);
+            batch->reserved[edge] += demand.bandwidth;
+            if (batch->reserved[edge] > capacity)
+                assert_capacity(batch, u, successors[k], capacity);
+        }
+    }
+    return index;
+}
+
+Z3_lbool tn_batch_solve(tn_batch batch)
+{
+    if (batch->model != NULL)
+    {
+        Z3_model_dec_ref(batch->ctx, batch->model);
+        batch->model = NULL;
+    }
+
+    tn_trace_span span = tn_trace_begin("Z3_solver_check", "solve");
+    tn_progress_check_begin(batch->ctx, batch->solver, 0, false);
+    Z3_lbool result = Z3_solver_check(batch->ctx, batch->solver);
+    tn_progress_check_end(batch->ctx, batch->solver, NULL);
+    char *statistics = tn_trace_z3_statistics(batch->ctx, batch->solver);
+    tn_trace_end_args(span, statistics);
+    free(statistics);
+    if (result == Z3_L_TRUE)
+    {
+        batch->model = Z3_solver_get_model(batch->ctx, batch->solver);
+        Z3_model_inc_ref(batch->ctx, batch->model);
+    }
+    return result;
+}
+
+int tn_batch_get_path(const tn_batch batch, int demand, tn_step *path)
+{
+    // La plus courte des longueurs choisies par le modèle (au moins une garde est vraie)
+    int length = 1;
+    while (length < batch->max_length && !value_of_var_in_model(batch->ctx, batch->model, length_guard(batch->ctx, demand, length)))
+        length++;
+    tn_get_path_from_model_copy(batch->ctx, batch->model, batch->network, demand_copy(batch, demand, length), length, path);
+    return length;
+}
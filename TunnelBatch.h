@@ -0,0 +1,90 @@
+#ifndef TUNNEL_BATCH_H
+#define TUNNEL_BATCH_H
+
+#include "TunnelNetwork.h"
+#include <z3.h>
+
+/**
+ * @file TunnelBatch.h
+ * @brief Simultaneous placement of several tunnels sharing the capacities of the edges.
+ *
+ * Each demand is encoded as in TunnelFailure: tn_reduction_copy for every length from 1 to the maximal length
+ * of the batch, each one guarded by a literal, and the OR of the guards. The capacity of each edge is a
+ * pseudo-Boolean constraint over the demands using it. Demands are added incrementally to a single solver:
+ * adding a demand only asserts its own paths and strengthens the capacity constraints of the edges it can use,
+ * the encoding of the other demands is kept.
+ *
+ * The capacities are indexed by edge, in the order of the sources then of the targets (the CSR order of
+ * tn_view_successors), so the batch takes no memory per pair of nodes.
+ *
+ * The guards, edge use literals and capacity constraints are built and asserted without taking references on
+ * them: the context must be created with Z3_mk_context, not Z3_mk_context_rc.
+ */
+
+/**
+ * @brief A tunnel to place: a path from @p source to @p target using @p bandwidth on each edge.
+ */
+typedef struct
+{
+    int source;
+    int target;
+    int bandwidth;
+} tn_demand;
+
+typedef struct tn_batch_s *tn_batch;
+
+/**
+ * @brief Creates an empty batch.
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork.
+ * @param max_length The maximal length of the tunnels.
+ * @param capacities One capacity per edge, the edges sorted by source then by target (a negative value means no
+ * limit). It is copied.
+ * @return tn_batch
+ */
+tn_batch tn_batch_create(Z3_context ctx, const TunnelNetwork network, int max_length, const int *capacities);
+
+/**
+ * @brief Frees the batch (not the context nor the network).
+ *
+ * @param batch A batch.
+ */
+void tn_batch_delete(tn_batch batch);
+
+/**
+ * @brief Adds a demand to the batch.
+ *
+ * @param batch A batch.
+ * @param demand The demand.
+ * @return int The index of the demand, or -1 if the memory limit stopped its encoding (the batch is unchanged).
+ */
+int tn_batch_add_demand(tn_batch batch, tn_demand demand);
+
+/**
+ * @brief Number of demands of the batch.
+ *
+ * @param batch A batch.
+ * @return int
+ */
+int tn_batch_num_demands(const tn_batch batch);
+
+/**
+ * @brief Looks for tunnels for all the demands at once, respecting the capacities.
+ *
+ * @param batch A batch.
+ * @return Z3_lbool Z3_L_TRUE if every demand can be placed, Z3_L_FALSE if not, Z3_L_UNDEF if the solver gave up.
+ */
+Z3_lbool tn_batch_solve(tn_batch batch);
+
+/**
+ * @brief Reads the tunnel of a demand after a successful tn_batch_solve.
+ *
+ * @param batch A batch.
+ * @param demand The index of the demand.
+ * @param path An array of tn_step of size at least the maximal length of the batch.
+ * @return int The length of the tunnel.
+ */
+int tn_batch_get_path(const tn_batch batch, int demand, tn_step *path);
+
+#endif
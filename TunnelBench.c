@@ -0,0 +1,392 @@
+#include "TunnelBench.h"
+#include "TunnelCommon.h"
+#include "TunnelEncoding.h"
+#include "TunnelMemory.h"
+#include "TunnelStats.h"
+#include "TunnelValidator.h"
+#include "TunnelView.h"
+#include "math.h"
+#include "stdlib.h"
+#include "string.h"
+#include <unistd.h>
+
+static const char *family_names[TN_BENCH_NUM_FAMILIES] = {"layered_wan", "grid", "scale_free", "ring_of_trees",
+                                                          "dense_mesh", "island_chain"};
+
+const char *tn_bench_family_name(tn_bench_family family)
+{
+    return family >= 0 && family < TN_BENCH_NUM_FAMILIES ? family_names[family] : "?";
+}
+
+bool tn_bench_parse_family(const char *name, tn_bench_family *family)
+{
+    for (int f = 0; f < TN_BENCH_NUM_FAMILIES; f++)
+        if (strcmp(name, family_names[f]) == 0)
+        {
+            *family = (tn_bench_family)f;
+            return true;
+        }
+    return false;
+}
+
+// ===== GÉNÉRATION =====
+
+typedef struct
+{
+    int *edges; // couples (source, cible)
+    int num_edges;
+    int capacity;
+} edge_list;
+
+static void add_edge(edge_list *list, int source, int target)
+{
+    if (source == target)
+        return;
+    if (list->num_edges == list->capacity)
+    {
+        list->capacity = list->capacity == 0 ? 64 : 2 * list->capacity;
+        list->edges = realloc(list->edges, 2 * (size_t)list->capacity * sizeof(int));
+    }
+    list->edges[2 * list->num_edges] = source;
+    list->edges[2 * list->num_edges + 1] = target;
+    list->num_edges++;
+}
+
+// Lien bidirectionnel
+static void add_link(edge_list *list, int u, int v)
+{
+    add_edge(list, u, v);
+    add_edge(list, v, u);
+}
+
+static int zone_protocol(int zone)
+{
+    return zone % 2 == 0 ? 4 : 6;
+}
+
+// Actions déduites des zones : transmission du protocole de la zone, push vers la zone suivante, pop vers la précédente
+static unsigned *zone_actions(int num_nodes, const int *zones, const edge_list *list)
+{
+    unsigned *actions = calloc(num_nodes, sizeof(unsigned));
+    for (int u = 0; u < num_nodes; u++)
+        actions[u] = tn_graph_action_bit(zone_protocol(zones[u]) == 4 ? transmit_4 : transmit_6);
+    for (int e = 0; e < list->num_edges; e++)
+    {
+        int u = list->edges[2 * e];
+        int v = list->edges[2 * e + 1];
+        if (zones[v] == zones[u] + 1)
+            actions[u] |= tn_graph_action_bit(zone_protocol(zones[u]) == 4 ? push_4_6 : push_6_4);
+        else if (zones[v] == zones[u] - 1)
+            actions[u] |= tn_graph_action_bit(zone_protocol(zones[v]) == 4 ? pop_4_6 : pop_6_4);
+    }
+    return actions;
+}
+
+static void generate_layered_wan(int num_nodes, int degree, unsigned *state, edge_list *list, int *zones)
+{
+    int width = (int)sqrt(num_nodes);
+    if (width < 1)
+        width = 1;
+    int num_layers = (num_nodes + width - 1) / width;
+    for (int u = 0; u < num_nodes; u++)
+    {
+        int layer = u / width;
+        zones[u] = 3 * layer >= num_layers && 3 * layer < 2 * num_layers ? 1 : 0;
+        int next = (layer + 1) * width;
+        if (next >= num_nodes)
+            continue;
+        int next_width = num_nodes - next < width ? num_nodes - next : width;
+        add_link(list, u, next + u % width % next_width);
+        for (int k = 1; k < degree; k++)
+            add_link(list, u, next + (int)(tn_next_random(state) % next_width));
+    }
+}
+
+static void generate_grid(int num_nodes, unsigned *state, edge_list *list, int *zones)
+{
+    (void)state;
+    int side = (int)ceil(sqrt(num_nodes));
+    for (int u = 0; u < num_nodes; u++)
+    {
+        int column = u % side;
+        zones[u] = 3 * column >= side && 3 * column < 2 * side ? 1 : 0;
+        if (column + 1 < side && u + 1 < num_nodes)
+            add_link(list, u, u + 1);
+        if (u + side < num_nodes)
+            add_link(list, u, u + side);
+    }
+}
+
+static void generate_scale_free(int num_nodes, int degree, unsigned *state, edge_list *list, int *zones)
+{
+    // Petite clique de départ, puis chaque nœud choisit ses voisins proportionnellement à leur degré :
+    // une extrémité d'un lien déjà présent
+    int core = degree + 1 < num_nodes ? degree + 1 : num_nodes;
+    for (int u = 0; u < core; u++)
+        for (int v = u + 1; v < core; v++)
+            add_link(list, u, v);
+    for (int u = core; u < num_nodes; u++)
+    {
+        int existing = list->num_edges;
+        for (int k = 0; k < degree; k++)
+        {
+            int v = existing > 0 ? list->edges[tn_next_random(state) % (2 * existing)] : 0;
+            add_link(list, u, v);
+        }
+    }
+    for (int u = 0; u < num_nodes; u++)
+        zones[u] = tn_random_unit(state) < 1.0 / 3 ? 1 : 0;
+}
+
+// Un huitième des nœuds sur l'anneau (au moins 3), en laissant au moins un nœud d'arbre
+static int ring_num_roots(int num_nodes)
+{
+    int num_roots = num_nodes / 8 > 3 ? num_nodes / 8 : 3;
+    return num_roots < num_nodes - 1 ? num_roots : num_nodes - 1;
+}
+
+static void generate_ring_of_trees(int num_nodes, int degree, edge_list *list, int *zones)
+{
+    int num_roots = ring_num_roots(num_nodes);
+    for (int u = 0; u < num_roots; u++)
+    {
+        zones[u] = 1;
+        if (num_roots > 1)
+            add_link(list, u, (u + 1) % num_roots);
+    }
+    // Les nœuds suivants forment des arbres numérotés en largeur, accrochés aux racines dans l'ordre
+    for (int u = num_roots; u < num_nodes; u++)
+    {
+        zones[u] = 0;
+        add_link(list, u, (u - num_roots) / degree);
+    }
+}
+
+static void generate_dense_mesh(int num_nodes, int degree, unsigned *state, edge_list *list, int *zones)
+{
+    double p = num_nodes > 1 && (double)degree / (num_nodes - 1) > 0.5 ? (double)degree / (num_nodes - 1) : 0.5;
+    for (int u = 0; u < num_nodes; u++)
+    {
+        zones[u] = tn_random_unit(state) < 1.0 / 3 ? 1 : 0;
+        for (int v = u + 1; v < num_nodes; v++)
+            if (tn_random_unit(state) < p)
+                add_link(list, u, v);
+    }
+}
+
+static void generate_island_chain(int num_nodes, int degree, edge_list *list, int *zones)
+{
+    static const int pattern[] = {0, 1, 2, 1};
+    int size = degree > 1 ? degree : 2;
+    for (int u = 0; u < num_nodes; u++)
+    {
+        int island = u / size;
+        int first = island * size;
+        zones[u] = pattern[island % 4];
+        for (int v = first; v < u; v++)
+            add_link(list, u, v);
+        if (u == first && island > 0)
+            add_link(list, first - 1, u);
+    }
+}
+
+tn_graph tn_bench_generate(tn_bench_family family, int num_nodes, int degree, unsigned seed)
+{
+    unsigned state = seed * 2654435761u + 1;
+    if (degree < 1)
+        degree = 1;
+    edge_list list = {NULL, 0, 0};
+    int *zones = calloc(num_nodes, sizeof(int));
+    int initial = 0;
+    int final = num_nodes - 1;
+
+    switch (family)
+    {
+    case tn_bench_layered_wan:
+        generate_layered_wan(num_nodes, degree, &state, &list, zones);
+        break;
+    case tn_bench_grid:
+        generate_grid(num_nodes, &state, &list, zones);
+        break;
+    case tn_bench_scale_free:
+        generate_scale_free(num_nodes, degree, &state, &list, zones);
+        break;
+    case tn_bench_ring_of_trees:
+        generate_ring_of_trees(num_nodes, degree, &list, zones);
+        initial = ring_num_roots(num_nodes);
+        break;
+    case tn_bench_dense_mesh:
+        generate_dense_mesh(num_nodes, degree, &state, &list, zones);
+        break;
+    default:
+        generate_island_chain(num_nodes, degree, &list, zones);
+        break;
+    }
+    zones[initial] = 0;
+    zones[final] = 0;
+
+    unsigned *actions = zone_actions(num_nodes, zones, &list);
+    tn_graph graph = tn_graph_create(num_nodes, NULL, actions, list.num_edges, list.edges, initial, final);
+    free(actions);
+    free(zones);
+    free(list.edges);
+    return graph;
+}
+
+// ===== MESURES =====
+
+// Pic de mémoire résidente depuis le début de la mesure (tn_memory_reset_peak)
+static long peak_rss_kb(void)
+{
+    tn_memory_usage usage;
+    tn_memory_read(&usage);
+    return (long)(usage.peak_rss_bytes / 1024);
+}
+
+bool tn_bench_run(tn_bench_family family, int num_nodes, int degree, int length, unsigned seed, const char *dot_file,
+                  tn_bench_measure *measure)
+{
+    memset(measure, 0, sizeof(*measure));
+    measure->family = family;
+    measure->num_nodes = num_nodes;
+    measure->degree = degree;
+    measure->length = length;
+    measure->result = -1;
+    tn_memory_reset_peak();
+
+    tn_graph generated = tn_bench_generate(family, num_nodes, degree, seed);
+    measure->num_edges = tn_graph_num_edges(generated);
+    bool saved = tn_graph_save_dot(generated, dot_file);
+    tn_graph_delete(generated);
+    if (!saved)
+        return false;
+
+    double start = tn_now();
+    tn_graph graph = tn_graph_load_dot(dot_file);
+    measure->parse_seconds = tn_now() - start;
+    if (graph == NULL)
+        return false;
+
+    Z3_config cfg = Z3_mk_config();
+    Z3_context ctx = Z3_mk_context(cfg);
+    Z3_del_config(cfg);
+
+    start = tn_now();
+    tn_view view = tn_view_from_graph(graph);
+    Z3_ast formula = tn_view_reduction_copy(ctx, view, 0, length);
+    measure->encode_seconds = tn_now() - start;
+    if (formula == NULL)
+    {
+        // Encodage arrêté par la limite de mémoire : résultat inconnu, sans chemin à vérifier
+        measure->valid = true;
+        Z3_del_context(ctx);
+        tn_view_delete(view);
+        tn_graph_delete(graph);
+        measure->peak_rss_kb = peak_rss_kb();
+        return true;
+    }
+    tn_formula_size size;
+    tn_stats_formula_size(ctx, formula, &size);
+    measure->num_variables = size.num_variables;
+    measure->num_clauses = size.num_clauses;
+
+    Z3_solver solver = Z3_mk_solver(ctx);
+    Z3_solver_inc_ref(ctx, solver);
+    Z3_solver_assert(ctx, solver, formula);
+    start = tn_now();
+    Z3_lbool answer = Z3_solver_check(ctx, solver);
+    measure->solve_seconds = tn_now() - start;
+    measure->result = answer == Z3_L_TRUE ? 1 : answer == Z3_L_FALSE ? 0 : -1;
+
+    measure->valid = true;
+    if (answer == Z3_L_TRUE)
+    {
+        tn_step *path = malloc(length * sizeof(tn_step));
+        start = tn_now();
+        Z3_model model = Z3_solver_get_model(ctx, solver);
+        Z3_model_inc_ref(ctx, model);
+        tn_view_get_path_from_model_copy(ctx, model, view, 0, length, path);
+        tn_path_check check = tn_view_check_path(view, tn_view_initial(view), tn_view_final(view), length, path);
+        measure->decode_seconds = tn_now() - start;
+        measure->valid = check.error == tn_path_valid;
+        Z3_model_dec_ref(ctx, model);
+        free(path);
+    }
+
+    Z3_solver_dec_ref(ctx, solver);
+    Z3_del_context(ctx);
+    tn_view_delete(view);
+    tn_graph_delete(graph);
+    measure->peak_rss_kb = peak_rss_kb();
+    return true;
+}
+
+// ===== SORTIE =====
+
+static const char *result_name(int result)
+{
+    return result == 1 ? "sat" : result == 0 ? "unsat" : "unknown";
+}
+
+static void print_measure(FILE *out, const tn_bench_measure *m, tn_bench_format format, bool first)
+{
+    if (format == tn_bench_csv)
+    {
+        fprintf(out, "%s,%d,%d,%d,%d,%.6f,%.6f,%.6f,%.6f,%ld,%ld,%s,%d,%ld\n", tn_bench_family_name(m->family),
+                m->num_nodes, m->num_edges, m->degree, m->length, m->parse_seconds, m->encode_seconds,
+                m->solve_seconds, m->decode_seconds, m->num_variables, m->num_clauses, result_name(m->result), m->valid,
+                m->peak_rss_kb);
+        return;
+    }
+    fprintf(out,
+            "%s\n  {\"family\": \"%s\", \"nodes\": %d, \"edges\": %d, \"degree\": %d, \"length\": %d, "
+            "\"parse_s\": %.6f, \"encode_s\": %.6f, \"solve_s\": %.6f, \"decode_s\": %.6f, "
+            "\"variables\": %ld, \"clauses\": %ld, \"result\": \"%s\", \"valid\": %s, \"peak_rss_kb\": %ld}",
+            first ? "" : ",", tn_bench_family_name(m->family), m->num_nodes, m->num_edges, m->degree, m->length,
+            m->parse_seconds, m->encode_seconds, m->solve_seconds, m->decode_seconds, m->num_variables,
+            m->num_clauses, result_name(m->result), m->valid ? "true" : "false", m->peak_rss_kb);
+}
+
+int tn_bench_sweep(int num_families, const tn_bench_family *families, int num_sizes, const int *sizes, int num_degrees,
+                   const int *degrees, int num_lengths, const int *lengths, unsigned seed, tn_bench_format format, FILE *out)
+{
+    char dot_file[] = "/tmp/tn_bench_XXXXXX";
+    int fd = mkstemp(dot_file);
+    if (fd < 0)
+    {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    if (format == tn_bench_csv)
+        fprintf(out, "family,nodes,edges,degree,length,parse_s,encode_s,solve_s,decode_s,variables,clauses,result,"
+                     "valid,peak_rss_kb\n");
+    else
+        fprintf(out, "[");
+
+    int failures = 0;
+    bool first = true;
+    for (int f = 0; f < num_families; f++)
+        for (int s = 0; s < num_sizes; s++)
+            for (int d = 0; d < num_degrees; d++)
+                for (int l = 0; l < num_lengths; l++)
+                {
+                    tn_bench_measure measure;
+                    if (!tn_bench_run(families[f], sizes[s], degrees[d], lengths[l], seed, dot_file, &measure))
+                    {
+                        failures++;
+                        continue;
+                    }
+                    if (!measure.valid)
+                        failures++;
+                    print_measure(out, &measure, format, first);
+                    first = false;
+                    fflush(out);
+                }
+
+    if (format == tn_bench_json)
+        fprintf(out, "\n]\n");
+    unlink(dot_file);
+    return failures;
+}
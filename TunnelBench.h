@@ -0,0 +1,127 @@
+#ifndef TUNNEL_BENCH_H
+#define TUNNEL_BENCH_H
+
+#include "TunnelGraph.h"
+#include <stdio.h>
+
+/**
+ * @file TunnelBench.h
+ * @brief End-to-end benchmark on generated families of networks.
+ *
+ * Each family lays its nodes out in zones: zone 0 speaks IPv4, zone 1 IPv6, zone 2 IPv4 tunnelled in IPv6, and
+ * so on. A node has the transmission of the protocol of its zone, pushes on its edges to the next zone and pops
+ * on its edges to the previous one, so that crossing a zone needs a tunnel. The initial and final nodes are in
+ * zone 0.
+ *
+ * A run saves the generated network as DOT, then measures loading it (parse), building the view and the
+ * reduction from the initial to the final node (encode), solving (solve) and reading and checking the path
+ * (decode), along with the size of the formula and the peak resident memory of the process.
+ */
+
+/**
+ * @brief The families of generated networks.
+ */
+typedef enum
+{
+    tn_bench_layered_wan,   ///< Layers of sqrt(n) nodes, each linked to degree nodes of the next layer; IPv6 core in the middle third.
+    tn_bench_grid,          ///< Square grid with 4 neighbours (degree is ignored); IPv6 band in the middle third of the columns.
+    tn_bench_scale_free,    ///< Preferential attachment, degree links per new node; a third of the nodes in IPv6.
+    tn_bench_ring_of_trees, ///< IPv6 ring of roots, each root carrying IPv4 trees of branching degree.
+    tn_bench_dense_mesh,    ///< Random links with probability max(1/2, degree / n); a third of the nodes in IPv6.
+    tn_bench_island_chain,  ///< Chain of cliques of degree nodes whose zones go 0, 1, 2, 1, 0, ... (push/pop islands).
+    TN_BENCH_NUM_FAMILIES
+} tn_bench_family;
+
+/**
+ * @brief Measures of a run. The times are in seconds, the memory in kilobytes.
+ */
+typedef struct
+{
+    tn_bench_family family;
+    int num_nodes;
+    int num_edges;
+    int degree;
+    int length;
+    double parse_seconds;
+    double encode_seconds;
+    double solve_seconds;
+    double decode_seconds;
+    long num_variables; ///< Distinct propositional variables of the formula.
+    long num_clauses;   ///< Conjuncts of the formula once its top-level conjunctions are flattened.
+    int result;         ///< 1 for SAT, 0 for UNSAT, -1 for UNKNOWN.
+    bool valid;         ///< The path found passes tn_view_check_path (true when there is no path).
+    long peak_rss_kb;   ///< Peak resident memory during the run (of the process so far if it cannot be reset).
+} tn_bench_measure;
+
+/**
+ * @brief Output formats of tn_bench_sweep.
+ */
+typedef enum
+{
+    tn_bench_csv,
+    tn_bench_json
+} tn_bench_format;
+
+/**
+ * @brief The name of a family ("layered_wan", "grid", ...).
+ *
+ * @param family A family.
+ * @return const char* Its name.
+ */
+const char *tn_bench_family_name(tn_bench_family family);
+
+/**
+ * @brief The family named @p name.
+ *
+ * @param name A name returned by tn_bench_family_name.
+ * @param family The family.
+ * @return true if the name is known.
+ */
+bool tn_bench_parse_family(const char *name, tn_bench_family *family);
+
+/**
+ * @brief Generates a network of a family.
+ *
+ * @param family The family.
+ * @param num_nodes The number of nodes (at least 2).
+ * @param degree The degree parameter of the family (at least 1).
+ * @param seed The seed of the random choices.
+ * @return tn_graph The network, to free with tn_graph_delete.
+ */
+tn_graph tn_bench_generate(tn_bench_family family, int num_nodes, int degree, unsigned seed);
+
+/**
+ * @brief Generates a network, saves it to @p dot_file and measures a run on it.
+ *
+ * @param family The family.
+ * @param num_nodes The number of nodes.
+ * @param degree The degree parameter.
+ * @param length The length of the path looked for.
+ * @param seed The seed of the generation.
+ * @param dot_file A scratch file for the DOT export.
+ * @param measure The measures.
+ * @return true on success, false if the DOT file cannot be written or read back.
+ */
+bool tn_bench_run(tn_bench_family family, int num_nodes, int degree, int length, unsigned seed, const char *dot_file,
+                  tn_bench_measure *measure);
+
+/**
+ * @brief Runs every combination of families, sizes, degrees and lengths and prints one record per run.
+ *
+ * @param num_families The number of families.
+ * @param families The families.
+ * @param num_sizes The number of sizes.
+ * @param sizes The numbers of nodes.
+ * @param num_degrees The number of degrees.
+ * @param degrees The degree parameters.
+ * @param num_lengths The number of lengths.
+ * @param lengths The lengths.
+ * @param seed The seed of the generation.
+ * @param format CSV (with a header line) or JSON (an array of objects).
+ * @param out The output stream.
+ * @return int The number of failed runs (invalid path or scratch file error).
+ */
+int tn_bench_sweep(int num_families, const tn_bench_family *families, int num_sizes, const int *sizes, int num_degrees,
+                   const int *degrees, int num_lengths, const int *lengths, unsigned seed, tn_bench_format format, FILE *out);
+
+#endif
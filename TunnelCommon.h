@@ -0,0 +1,131 @@
+#ifndef TUNNEL_COMMON_H
+#define TUNNEL_COMMON_H
+
+#include "TunnelNetwork.h"
+#include <time.h>
+#include <z3.h>
+
+/**
+ * @file TunnelCommon.h
+ * @brief Internal helpers shared by the modules: the list of actions, a monotonic clock, a seeded generator and
+ * the reference counting of the encoders.
+ *
+ * Not part of the interface of any module: only the .c files include it. An encoder that counts its calls to Z3
+ * (TN_STATS_WRAP_Z3) includes it after TunnelStats.h, so that the calls made by the reference helpers are counted.
+ */
+
+/**
+ * @brief The ten actions, in the order of the bits of the action masks (tn_graph_parse_label, tn_view).
+ */
+static const action tn_all_actions[] = {transmit_4, transmit_6, push_4_4, push_4_6, push_6_4,
+                                        push_6_6, pop_4_4, pop_4_6, pop_6_4, pop_6_6};
+
+#define TN_NUM_ACTIONS ((int)(sizeof(tn_all_actions) / sizeof(tn_all_actions[0])))
+
+/**
+ * @brief Seconds on the monotonic clock, for durations.
+ *
+ * @return double
+ */
+static inline double tn_now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Next value of a xorshift32 generator: the same seed gives the same sequence on every machine.
+ *
+ * @param state The state of the generator, not 0.
+ * @return unsigned
+ */
+static inline unsigned tn_next_random(unsigned *state)
+{
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * @brief Uniform value in [0, 1) drawn from tn_next_random.
+ *
+ * @param state The state of the generator.
+ * @return double
+ */
+static inline double tn_random_unit(unsigned *state)
+{
+    return (tn_next_random(state) >> 8) / 16777216.0;
+}
+
+/*
+ * In a context created with Z3_mk_context_rc, a formula without reference can be freed by the next call to the
+ * API. Every formula kept in an array while others are built is therefore taken with own, every builder returns
+ * a formula of which the caller owns one reference, and the sub-formulas are released as soon as the formula
+ * containing them is built. In a context created with Z3_mk_context, these counts are balanced and have no effect.
+ */
+
+/**
+ * @brief Takes a reference on @p formula.
+ *
+ * @param ctx The solver context.
+ * @param formula A formula.
+ * @return Z3_ast @p formula
+ */
+static inline Z3_ast own(Z3_context ctx, Z3_ast formula)
+{
+    Z3_inc_ref(ctx, formula);
+    return formula;
+}
+
+/**
+ * @brief Releases the reference owned on each of the @p n formulas.
+ *
+ * @param ctx The solver context.
+ * @param n The number of formulas.
+ * @param formulas The formulas.
+ */
+static inline void release(Z3_context ctx, int n, Z3_ast *formulas)
+{
+    for (int i = 0; i < n; i++)
+        Z3_dec_ref(ctx, formulas[i]);
+}
+
+/**
+ * @brief AND of @p n owned formulas, which are released.
+ *
+ * @param ctx The solver context.
+ * @param n The number of formulas.
+ * @param formulas The formulas.
+ * @return Z3_ast The conjunction, owned (true if @p n is 0).
+ */
+static inline Z3_ast and_release(Z3_context ctx, int n, Z3_ast *formulas)
+{
+    if (n == 0)
+        return own(ctx, Z3_mk_true(ctx));
+    Z3_ast result = own(ctx, Z3_mk_and(ctx, n, formulas));
+    release(ctx, n, formulas);
+    return result;
+}
+
+/**
+ * @brief OR of @p n owned formulas, which are released.
+ *
+ * @param ctx The solver context.
+ * @param n The number of formulas.
+ * @param formulas The formulas.
+ * @return Z3_ast The disjunction, owned (false if @p n is 0).
+ */
+static inline Z3_ast or_release(Z3_context ctx, int n, Z3_ast *formulas)
+{
+    if (n == 0)
+        return own(ctx, Z3_mk_false(ctx));
+    Z3_ast result = own(ctx, Z3_mk_or(ctx, n, formulas));
+    release(ctx, n, formulas);
+    return result;
+}
+
+#endif
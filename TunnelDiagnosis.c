@@ -0,0 +1,161 @@
+#include "TunnelDiagnosis.h"
+#include "TunnelReduction.h"
+#include "Z3Tools.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+static const char *group_names[] = {
+    "formula_initial_and_final_positions (initial)",
+    "formula_initial_and_final_positions (final)",
+    "formula_simple_path",
+    "formula_unique_node_per_position",
+    "formula_valid_transitions (stack)",
+    "formula_valid_transitions (edges and actions)",
+};
+
+// Dernière position dont dépend le groupe (-1 si aucune)
+static int last_position(const tn_formula_group *group, int length)
+{
+    switch (group->kind)
+    {
+    case tn_group_simple_path:
+        return -1;
+    case tn_group_stack:
+        return group->pos < length ? group->pos + 1 : group->pos;
+    case tn_group_transitions:
+        return group->pos + 1;
+    default:
+        return group->pos;
+    }
+}
+
+// Première position dont dépend le groupe (-1 si aucune)
+static int first_position(const tn_formula_group *group)
+{
+    return group->pos;
+}
+
+static Z3_ast group_literal(Z3_context ctx, int index)
+{
+    char name[40];
+    snprintf(name, 40, "group %d", index);
+    return mk_bool_var(ctx, name);
+}
+
+void tn_diagnose(Z3_context ctx, const TunnelNetwork network, int length, tn_diagnosis *diagnosis)
+{
+    int num_groups = tn_reduction_num_groups(length);
+    tn_formula_group *groups = malloc(num_groups * sizeof(tn_formula_group));
+    Z3_ast *literals = malloc(num_groups * sizeof(Z3_ast));
+    num_groups = tn_reduction_groups(ctx, network, length, groups);
+
+    diagnosis->length = length;
+    diagnosis->num_core = 0;
+    diagnosis->core = NULL;
+    diagnosis->all_longer_unsat = false;
+    if (num_groups < 0)
+    {
+        // Encodage arrêté par la limite de mémoire : rien n'est conclu
+        diagnosis->result = Z3_L_UNDEF;
+        free(literals);
+        free(groups);
+        return;
+    }
+
+    Z3_solver solver = Z3_mk_solver(ctx);
+    Z3_solver_inc_ref(ctx, solver);
+    Z3_params params = Z3_mk_params(ctx);
+    Z3_params_inc_ref(ctx, params);
+    Z3_params_set_bool(ctx, params, Z3_mk_string_symbol(ctx, "core.minimize"), true);
+    Z3_solver_set_params(ctx, solver, params);
+    Z3_params_dec_ref(ctx, params);
+
+    for (int i = 0; i < num_groups; i++)
+    {
+        literals[i] = group_literal(ctx, i);
+        Z3_solver_assert(ctx, solver, Z3_mk_implies(ctx, literals[i], groups[i].formula));
+    }
+
+    diagnosis->result = Z3_solver_check_assumptions(ctx, solver, num_groups, literals);
+
+    if (diagnosis->result == Z3_L_FALSE)
+    {
+        Z3_ast_vector core = Z3_solver_get_unsat_core(ctx, solver);
+        Z3_ast_vector_inc_ref(ctx, core);
+        unsigned size = Z3_ast_vector_size(ctx, core);
+        diagnosis->core = malloc((size > 0 ? size : 1) * sizeof(tn_formula_group));
+
+        // Le core ne porte que sur un début (ou une fin) de chemin qui ne voit pas la borne de la pile ?
+        int stack_size = get_stack_size(length);
+        bool prefix_only = true;
+        bool suffix_only = true;
+        for (unsigned c = 0; c < size; c++)
+        {
+            Z3_ast literal = Z3_ast_vector_get(ctx, core, c);
+            for (int i = 0; i < num_groups; i++)
+            {
+                if (!Z3_is_eq_ast(ctx, literal, literals[i]))
+                    continue;
+                diagnosis->core[diagnosis->num_core++] = groups[i];
+                if (groups[i].kind == tn_group_final || last_position(&groups[i], length) >= stack_size)
+                    prefix_only = false;
+                if (groups[i].kind == tn_group_initial || (groups[i].pos >= 0 && length - first_position(&groups[i]) >= stack_size))
+                    suffix_only = false;
+            }
+        }
+        diagnosis->all_longer_unsat = prefix_only || suffix_only;
+        Z3_ast_vector_dec_ref(ctx, core);
+    }
+
+    Z3_solver_dec_ref(ctx, solver);
+    free(literals);
+    free(groups);
+}
+
+void tn_diagnosis_free(tn_diagnosis *diagnosis)
+{
+    free(diagnosis->core);
+    diagnosis->core = NULL;
+    diagnosis->num_core = 0;
+}
+
+void tn_print_diagnosis(const TunnelNetwork network, const tn_diagnosis *diagnosis)
+{
+    if (diagnosis->result != Z3_L_FALSE)
+    {
+        printf("Length %d: %s\n", diagnosis->length, diagnosis->result == Z3_L_TRUE ? "a valid path exists" : "unknown");
+        return;
+    }
+    printf("Length %d: no valid path from %s to %s, conflicting constraints:\n", diagnosis->length,
+           tn_get_node_name(network, tn_get_initial(network)), tn_get_node_name(network, tn_get_final(network)));
+    for (int i = 0; i < diagnosis->num_core; i++)
+    {
+        if (diagnosis->core[i].pos < 0)
+            printf("  %s\n", group_names[diagnosis->core[i].kind]);
+        else
+            printf("  %s at pos %d\n", group_names[diagnosis->core[i].kind], diagnosis->core[i].pos);
+    }
+    if (diagnosis->all_longer_unsat)
+        printf("No longer length can have a valid path either.\n");
+}
+
+int tn_sweep_lengths(Z3_context ctx, const TunnelNetwork network, int max_length, bool verbose)
+{
+    for (int length = 1; length <= max_length; length++)
+    {
+        tn_diagnosis diagnosis;
+        tn_diagnose(ctx, network, length, &diagnosis);
+        if (verbose && diagnosis.result != Z3_L_TRUE)
+            tn_print_diagnosis(network, &diagnosis);
+
+        Z3_lbool result = diagnosis.result;
+        bool stop = diagnosis.all_longer_unsat;
+        tn_diagnosis_free(&diagnosis);
+
+        if (result == Z3_L_TRUE)
+            return length;
+        if (stop)
+            return -1;
+    }
+    return -1;
+}
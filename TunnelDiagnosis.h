@@ -0,0 +1,71 @@
+#ifndef TUNNEL_DIAGNOSIS_H
+#define TUNNEL_DIAGNOSIS_H
+
+#include "TunnelEncoding.h"
+#include "TunnelNetwork.h"
+#include <stdbool.h>
+#include <z3.h>
+
+/**
+ * @file TunnelDiagnosis.h
+ * @brief Explanation of the lengths for which there is no valid path, from a minimal unsat core of tn_reduction.
+ *
+ * Each group of tn_reduction_groups is asserted under its own assumption literal. When the length is UNSAT,
+ * the minimal core tells which sub-formulas and positions are in conflict. If the core does not involve the
+ * final position and only involves positions p with p <= length / 2 (so that the stack bound does not matter),
+ * then no path can even start the way the core requires: every longer length is UNSAT too. Symmetrically, a core
+ * without the initial position and within length / 2 positions of the end means no path can end that way.
+ *
+ * The formulas of the groups, kept in the core returned, and the assumption literals carry no reference: only a
+ * context created with Z3_mk_context is supported, not one created with Z3_mk_context_rc.
+ */
+
+typedef struct
+{
+    Z3_lbool result;
+    int length;
+    int num_core;
+    tn_formula_group *core;
+    bool all_longer_unsat; // Every length >= length is UNSAT as well
+} tn_diagnosis;
+
+/**
+ * @brief Solves the reduction of length @p length and, if it is UNSAT, extracts a minimal core of groups.
+ *
+ * The result is Z3_L_UNDEF when the memory limit stops the encoding.
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork.
+ * @param length The length of the sought path.
+ * @param diagnosis The result, to free with tn_diagnosis_free.
+ */
+void tn_diagnose(Z3_context ctx, const TunnelNetwork network, int length, tn_diagnosis *diagnosis);
+
+/**
+ * @brief Frees the core of a diagnosis.
+ *
+ * @param diagnosis A diagnosis.
+ */
+void tn_diagnosis_free(tn_diagnosis *diagnosis);
+
+/**
+ * @brief Prints the diagnosis for operators.
+ *
+ * @param network A TunnelNetwork.
+ * @param diagnosis A diagnosis.
+ */
+void tn_print_diagnosis(const TunnelNetwork network, const tn_diagnosis *diagnosis);
+
+/**
+ * @brief Looks for the smallest length from 1 to @p max_length with a valid path, stopping as soon as a core
+ * proves that no longer length can work.
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork.
+ * @param max_length The maximal length.
+ * @param verbose If true, prints the diagnosis of each UNSAT length.
+ * @return int The smallest length with a valid path, or -1.
+ */
+int tn_sweep_lengths(Z3_context ctx, const TunnelNetwork network, int max_length, bool verbose);
+
+#endif
@@ -0,0 +1,332 @@
+#ifndef TUNNEL_ENCODING_H
+#define TUNNEL_ENCODING_H
+
+#include "TunnelNetwork.h"
+#include "TunnelView.h"
+#include <z3.h>
+
+/**
+ * @file TunnelEncoding.h
+ * @brief Building blocks of tn_reduction, for encodings that put several paths in the same solver.
+ *
+ * Each path is identified by a copy number. The copy 0 uses exactly the variables of tn_reduction
+ * (tn_path_variable, tn_4_variable, tn_6_variable), the other copies use prefixed variables.
+ *
+ * The formulas can be built in a context created with Z3_mk_context_rc: the sub-formulas are released as
+ * soon as the formula containing them is built, and every formula returned by these functions and by
+ * tn_reduction (variables excepted) carries one reference owned by the caller, to release with Z3_dec_ref
+ * once asserted. In a context created with Z3_mk_context, the reference counts have no effect and the
+ * formulas can be used without releasing them. TunnelBatch, TunnelFailure, TunnelLive, TunnelEnumeration and
+ * TunnelDiagnosis keep formulas without references across calls and only support Z3_mk_context.
+ *
+ * Under a memory limit (tn_memory_set_limit), the encodings that stop early fail closed: they release what was
+ * built and return NULL (tn_reduction_groups returns -1), never a weaker formula.
+ */
+
+/**
+ * @brief Creates the variable "x_{node,pos,stack_height}" of the copy @p copy of the path.
+ *
+ * @param ctx The solver context.
+ * @param copy The copy of the path.
+ * @param node A node.
+ * @param pos The path position.
+ * @param stack_height The highest cell occupied of the stack at that position.
+ * @return Z3_ast
+ */
+Z3_ast tn_path_variable_copy(Z3_context ctx, int copy, int node, int pos, int stack_height);
+
+/**
+ * @brief Creates the variable "y_{pos,height,4}" of the copy @p copy of the path.
+ *
+ * @param ctx The solver context.
+ * @param copy The copy of the path.
+ * @param pos The path position.
+ * @param height The height of the cell described.
+ * @return Z3_ast
+ */
+Z3_ast tn_4_variable_copy(Z3_context ctx, int copy, int pos, int height);
+
+/**
+ * @brief Creates the variable "y_{pos,height,6}" of the copy @p copy of the path.
+ *
+ * @param ctx The solver context.
+ * @param copy The copy of the path.
+ * @param pos The path position.
+ * @param height The height of the cell described.
+ * @return Z3_ast
+ */
+Z3_ast tn_6_variable_copy(Z3_context ctx, int copy, int pos, int height);
+
+/**
+ * @brief Formula true iff the copy @p copy of the path is on @p node at position @p pos (whatever the stack height).
+ *
+ * @param ctx The solver context.
+ * @param copy The copy of the path.
+ * @param node A node.
+ * @param pos The path position.
+ * @param length The length of the path.
+ * @return Z3_ast
+ */
+Z3_ast tn_node_at_position(Z3_context ctx, int copy, int node, int pos, int length);
+
+/**
+ * @brief Same as tn_reduction, for the copy @p copy of the path and for arbitrary endpoints.
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork.
+ * @param copy The copy of the path.
+ * @param source The first node of the path.
+ * @param target The last node of the path.
+ * @param length The length of the sought path.
+ * @return Z3_ast The formula.
+ */
+Z3_ast tn_reduction_copy(Z3_context ctx, const TunnelNetwork network, int copy, int source, int target, int length);
+
+/**
+ * @brief The part of tn_reduction_copy that depends neither on the edges nor on the actions of the nodes.
+ *
+ * tn_reduction_copy is this skeleton and tn_node_transitions_copy for every node.
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork (only its number of nodes is used).
+ * @param copy The copy of the path.
+ * @param source The first node of the path.
+ * @param target The last node of the path.
+ * @param length The length of the sought path.
+ * @return Z3_ast The formula.
+ */
+Z3_ast tn_reduction_skeleton_copy(Z3_context ctx, const TunnelNetwork network, int copy, int source, int target, int length);
+
+/**
+ * @brief The valid transitions leaving @p node, for explicitly given successors and actions.
+ *
+ * @param ctx The solver context.
+ * @param copy The copy of the path.
+ * @param node A node.
+ * @param num_successors The number of successors of @p node.
+ * @param successors The successors of @p node.
+ * @param num_actions The number of actions of @p node.
+ * @param actions The actions of @p node.
+ * @param length The length of the sought path.
+ * @return Z3_ast The formula.
+ */
+Z3_ast tn_node_transitions_copy(Z3_context ctx, int copy, int node, int num_successors, const int *successors,
+                                int num_actions, const action *actions, int length);
+
+/**
+ * @brief Creates the literal enabling the edge @p source -> @p target in the guarded reductions.
+ *
+ * @param ctx The solver context.
+ * @param source The source of the edge.
+ * @param target The target of the edge.
+ * @return Z3_ast
+ */
+Z3_ast tn_edge_enable_variable(Z3_context ctx, int source, int target);
+
+/**
+ * @brief Same as tn_reduction_copy, but an edge u -> v can only be used if tn_edge_enable_variable(u, v) is true.
+ *
+ * Failures of links are then checked with assumptions on the enable literals, without rebuilding the formula.
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork.
+ * @param copy The copy of the path.
+ * @param source The first node of the path.
+ * @param target The last node of the path.
+ * @param length The length of the sought path.
+ * @return Z3_ast The formula.
+ */
+Z3_ast tn_guarded_reduction_copy(Z3_context ctx, const TunnelNetwork network, int copy, int source, int target, int length);
+
+/**
+ * @brief Same as tn_get_path_from_model, for the copy @p copy of the path.
+ *
+ * @param ctx The solver context.
+ * @param model A variable assignment.
+ * @param network A TunnelNetwork.
+ * @param copy The copy of the path.
+ * @param bound The length of the path.
+ * @param path An array of tn_step of size at least @p bound.
+ */
+void tn_get_path_from_model_copy(Z3_context ctx, Z3_model model, TunnelNetwork network, int copy, int bound, tn_step *path);
+
+/**
+ * @brief Same as tn_reduction_copy from the initial to the final node of a view, without rebuilding the view.
+ *
+ * The functions taking a TunnelNetwork build a tn_view once per call; this one lets the caller reuse a view, or
+ * encode a graph loaded with tn_graph_load_dot or tn_graph_load_snapshot (see tn_view_from_graph).
+ *
+ * @param ctx The solver context.
+ * @param view A view of the network.
+ * @param copy The copy of the path.
+ * @param length The length of the sought path.
+ * @return Z3_ast The formula.
+ */
+Z3_ast tn_view_reduction_copy(Z3_context ctx, const tn_view view, int copy, int length);
+
+/**
+ * @brief The part of tn_view_reduction_copy that does not depend on the endpoints of the path.
+ *
+ * Asserted once in a solver, it can answer queries for any (source, target) pair by adding
+ * tn_view_endpoints_copy under Z3_solver_push / Z3_solver_pop or as assumptions.
+ *
+ * @param ctx The solver context.
+ * @param view A view of the network.
+ * @param copy The copy of the path.
+ * @param length The length of the sought path.
+ * @return Z3_ast The formula.
+ */
+Z3_ast tn_view_reduction_body_copy(Z3_context ctx, const tn_view view, int copy, int length);
+
+/**
+ * @brief Same formula as tn_view_reduction_body_copy, built on @p num_threads threads.
+ *
+ * Each thread builds the uniqueness and transition constraints of a range of positions, and the simple-path
+ * constraints of a range of nodes, in its own Z3 context. The slices are then translated into @p ctx one after
+ * the other. With @p num_threads <= 1, this is tn_view_reduction_body_copy.
+ *
+ * @param ctx The solver context.
+ * @param view A view of the network (only read by the threads).
+ * @param copy The copy of the path.
+ * @param length The length of the sought path.
+ * @param num_threads The number of threads.
+ * @return Z3_ast The formula.
+ */
+Z3_ast tn_view_parallel_reduction_body_copy(Z3_context ctx, const tn_view view, int copy, int length, int num_threads);
+
+/**
+ * @brief The constraints on the first and last positions of the path (node, stack height 0 and stack [4]).
+ *
+ * @param ctx The solver context.
+ * @param view A view of the network.
+ * @param copy The copy of the path.
+ * @param source The first node of the path.
+ * @param target The last node of the path.
+ * @param length The length of the sought path.
+ * @return Z3_ast The formula.
+ */
+Z3_ast tn_view_endpoints_copy(Z3_context ctx, const tn_view view, int copy, int source, int target, int length);
+
+/**
+ * @brief The top-level builders of tn_view_reduction_copy, for tn_view_formula_part_copy.
+ */
+typedef enum
+{
+    tn_part_initial_and_final, // formula_initial_and_final_positions, between the initial and final nodes of the view
+    tn_part_unique_node,       // formula_unique_node_per_position
+    tn_part_simple_path,       // formula_simple_path
+    tn_part_valid_transitions  // formula_valid_transitions, including the evolution of the stack
+} tn_formula_part;
+
+/**
+ * @brief One top-level builder of tn_view_reduction_copy alone, so that it can be timed in isolation. The
+ * conjunction of the four parts is tn_view_reduction_copy.
+ *
+ * @param ctx The solver context.
+ * @param view A view of the network.
+ * @param part The builder.
+ * @param copy The copy of the path.
+ * @param length The length of the sought path.
+ * @return Z3_ast The formula.
+ */
+Z3_ast tn_view_formula_part_copy(Z3_context ctx, const tn_view view, tn_formula_part part, int copy, int length);
+
+/**
+ * @brief Same as tn_get_path_from_model_copy, for a path encoded with tn_view_reduction_copy.
+ *
+ * @param ctx The solver context.
+ * @param model A variable assignment.
+ * @param view A view of the network.
+ * @param copy The copy of the path.
+ * @param bound The length of the path.
+ * @param path An array of tn_step of size at least @p bound.
+ */
+void tn_view_get_path_from_model_copy(Z3_context ctx, Z3_model model, const tn_view view, int copy, int bound, tn_step *path);
+
+/**
+ * @brief Formula satisfiable iff there are @p num_paths valid paths of length 1 to @p max_length from the initial
+ * to the final node that share no node except their endpoints.
+ *
+ * Each path has one copy per length, guarded by a literal, and at least one of its guards is true: a single
+ * check searches the lengths of all the paths at once. The copies whose length is not chosen use no node. The
+ * simple path constraint of tn_reduction is extended to the union of all copies for the inner nodes, and the
+ * direct edge from the initial to the final node, which has no inner node, is used by at most one path of
+ * length 1.
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork.
+ * @param num_paths The number of paths.
+ * @param max_length The maximal length of each path.
+ * @return Z3_ast The formula.
+ */
+Z3_ast tn_disjoint_reduction(Z3_context ctx, const TunnelNetwork network, int num_paths, int max_length);
+
+/**
+ * @brief Reads the paths of tn_disjoint_reduction in a model.
+ *
+ * @param ctx The solver context.
+ * @param model A variable assignment.
+ * @param network A TunnelNetwork.
+ * @param num_paths The number of paths.
+ * @param max_length The maximal length of each path.
+ * @param paths @p num_paths arrays of tn_step, each of size at least @p max_length.
+ * @param lengths An array of size @p num_paths, receives the length of each path.
+ */
+void tn_get_disjoint_paths_from_model(Z3_context ctx, Z3_model model, TunnelNetwork network, int num_paths, int max_length, tn_step **paths, int *lengths);
+
+/**
+ * @brief The part of tn_reduction_copy that only involves the path variables: exactly one (node, height) per
+ * position and each node at most once. It does not depend on how the stack is encoded.
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork (only its number of nodes is used).
+ * @param copy The copy of the path.
+ * @param length The length of the sought path.
+ * @return Z3_ast The formula.
+ */
+Z3_ast tn_path_structure_copy(Z3_context ctx, const TunnelNetwork network, int copy, int length);
+
+/**
+ * @brief The sub-formulas of tn_reduction, as listed by tn_reduction_groups.
+ */
+typedef enum
+{
+    tn_group_initial,      // formula_initial_and_final_positions, position 0
+    tn_group_final,        // formula_initial_and_final_positions, position length
+    tn_group_simple_path,  // formula_simple_path
+    tn_group_unique,       // formula_unique_node_per_position, one position
+    tn_group_stack,        // stack of one position and its copy to the next one
+    tn_group_transitions   // formula_valid_transitions, from one position to the next one
+} tn_group_kind;
+
+/**
+ * @brief A part of tn_reduction: its kind, its position (-1 if it has none) and its formula.
+ */
+typedef struct
+{
+    tn_group_kind kind;
+    int pos;
+    Z3_ast formula;
+} tn_formula_group;
+
+/**
+ * @brief Number of groups written by tn_reduction_groups.
+ *
+ * @param length The length of the sought path.
+ * @return int
+ */
+int tn_reduction_num_groups(int length);
+
+/**
+ * @brief Splits tn_reduction into groups, per sub-formula and per position. Their conjunction is equivalent to
+ * tn_reduction(ctx, network, length).
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork.
+ * @param length The length of the sought path.
+ * @param groups An array of size at least tn_reduction_num_groups(length).
+ * @return int The number of groups written, or -1 if the memory limit stopped the encoding (no group is kept).
+ */
+int tn_reduction_groups(Z3_context ctx, const TunnelNetwork network, int length, tn_formula_group *groups);
+
+#endif
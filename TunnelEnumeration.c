@@ -0,0 +1,105 @@
+#include "TunnelEnumeration.h"
+#include "TunnelEncoding.h"
+#include "TunnelReduction.h"
+#include "Z3Tools.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+// Littéral qui active la réduction de longueur length dans le solveur commun
+static Z3_ast length_guard(Z3_context ctx, int length)
+{
+    char name[40];
+    snprintf(name, 40, "enumerate length %d", length);
+    return mk_bool_var(ctx, name);
+}
+
+// Variation de la hauteur de la pile causée par une action
+static int height_delta(action act)
+{
+    if (act == push_4_4 || act == push_4_6 || act == push_6_4 || act == push_6_6)
+        return 1;
+    if (act == pop_4_4 || act == pop_4_6 || act == pop_6_4 || act == pop_6_6)
+        return -1;
+    return 0;
+}
+
+/**
+ * Clause bloquant le chemin trouvé : NOT(AND_{pos} x_{node_pos,pos,height_pos}), seulement sur les littéraux du
+ * chemin, la hauteur de chaque position étant celle de la pile le long du chemin décodé. Les variables de
+ * contenu de la pile n'y apparaissent pas, ce qui élimine tous les modèles qui ne diffèrent que par elles, mais
+ * deux tunnels passant par les mêmes nœuds avec des hauteurs différentes restent distincts.
+ */
+static Z3_ast blocking_clause(Z3_context ctx, const tn_step *path, int length)
+{
+    Z3_ast *literals = malloc((length + 1) * sizeof(Z3_ast));
+    int height = 0;
+    for (int pos = 0; pos < length; pos++)
+    {
+        literals[pos] = Z3_mk_not(ctx, tn_path_variable_copy(ctx, 0, path[pos].source, pos, height));
+        height += height_delta(path[pos].action);
+    }
+    literals[length] = Z3_mk_not(ctx, tn_path_variable_copy(ctx, 0, path[length - 1].target, length, height));
+    Z3_ast clause = Z3_mk_or(ctx, length + 1, literals);
+    free(literals);
+    return clause;
+}
+
+long tn_enumerate_paths(Z3_context ctx, const TunnelNetwork network, int max_length, tn_path_callback callback, void *data)
+{
+    Z3_solver solver = Z3_mk_solver(ctx);
+    Z3_solver_inc_ref(ctx, solver);
+    tn_step *path = malloc((max_length > 0 ? max_length : 1) * sizeof(tn_step));
+    long count = 0;
+    bool stop = false;
+
+    for (int length = 1; length <= max_length && !stop; length++)
+    {
+        // La réduction de cette longueur n'est active que sous l'hypothèse guard
+        Z3_ast guard = length_guard(ctx, length);
+        Z3_ast reduction = tn_reduction(ctx, network, length);
+        if (reduction == NULL)
+        {
+            // Encodage arrêté par la limite de mémoire : le décompte serait faux
+            count = -1;
+            break;
+        }
+        Z3_solver_assert(ctx, solver, Z3_mk_implies(ctx, guard, reduction));
+
+        while (!stop)
+        {
+            Z3_lbool result = Z3_solver_check_assumptions(ctx, solver, 1, &guard);
+            if (result == Z3_L_FALSE)
+                break;
+            if (result == Z3_L_UNDEF)
+            {
+                // Le solveur a abandonné : le décompte serait partiel
+                count = -1;
+                stop = true;
+                break;
+            }
+
+            Z3_model model = Z3_solver_get_model(ctx, solver);
+            Z3_model_inc_ref(ctx, model);
+            tn_get_path_from_model(ctx, model, network, length, path);
+            Z3_model_dec_ref(ctx, model);
+
+            count++;
+            if (callback != NULL && !callback(path, length, data))
+                stop = true;
+
+            Z3_solver_assert(ctx, solver, Z3_mk_implies(ctx, guard, blocking_clause(ctx, path, length)));
+        }
+
+        // Les contraintes de cette longueur ne servent plus
+        Z3_solver_assert(ctx, solver, Z3_mk_not(ctx, guard));
+    }
+
+    free(path);
+    Z3_solver_dec_ref(ctx, solver);
+    return count;
+}
+
+long tn_count_paths(Z3_context ctx, const TunnelNetwork network, int max_length)
+{
+    return tn_enumerate_paths(ctx, network, max_length, NULL, NULL);
+}
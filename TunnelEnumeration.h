@@ -0,0 +1,55 @@
+#ifndef TUNNEL_ENUMERATION_H
+#define TUNNEL_ENUMERATION_H
+
+#include "TunnelNetwork.h"
+#include <stdbool.h>
+#include <z3.h>
+
+/**
+ * @file TunnelEnumeration.h
+ * @brief Enumeration of all the valid paths of a TunnelNetwork up to a given length.
+ *
+ * A single solver holds tn_reduction for every length, each one guarded by an assumption literal. After each
+ * model, the found path is blocked by a clause over its x_{node,pos,height} literals only (one per position), so
+ * two paths visiting the same nodes with the same stack heights but different stack contents are reported
+ * once, while two paths visiting the same nodes with different push/pop profiles are both reported.
+ *
+ * The reductions and blocking clauses are asserted without reference counting, which requires a context
+ * created with Z3_mk_context rather than Z3_mk_context_rc.
+ */
+
+/**
+ * @brief Called for each path found. The path is only valid during the call.
+ *
+ * @param path The steps of the path.
+ * @param length The length of the path.
+ * @param data The pointer given to tn_enumerate_paths.
+ * @return true to continue the enumeration, false to stop it.
+ */
+typedef bool (*tn_path_callback)(const tn_step *path, int length, void *data);
+
+/**
+ * @brief Calls @p callback on each valid path of length 1 to @p max_length, by increasing length.
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork.
+ * @param max_length The maximal length of the paths.
+ * @param callback The function called on each path (may be NULL).
+ * @param data Passed to @p callback.
+ * @return long The number of paths found, or -1 if the enumeration is incomplete: the memory limit stopped an
+ * encoding or the solver gave up (the paths already passed to @p callback are not the whole set).
+ */
+long tn_enumerate_paths(Z3_context ctx, const TunnelNetwork network, int max_length, tn_path_callback callback, void *data);
+
+/**
+ * @brief Number of valid paths of length 1 to @p max_length (paths differing only by their stack contents count
+ * once).
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork.
+ * @param max_length The maximal length of the paths.
+ * @return long The number of paths, or -1 as for tn_enumerate_paths.
+ */
+long tn_count_paths(Z3_context ctx, const TunnelNetwork network, int max_length);
+
+#endif
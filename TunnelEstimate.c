@@ -0,0 +1,78 @@
+#include "TunnelEstimate.h"
+#include "TunnelReduction.h"
+
+static uint64_t count_bits(unsigned mask)
+{
+    uint64_t count = 0;
+    for (; mask != 0; mask &= mask - 1)
+        count++;
+    return count;
+}
+
+// Tout sauf les transitions de formula_transitions_from_node, qui ne dépendent que de n, L et S
+static void estimate_without_transitions(uint64_t n, uint64_t L, uint64_t S, tn_size_estimate *estimate)
+{
+    // x_{node,pos,h} et y4/y6_{pos,h}
+    estimate->num_variables = (n + 2) * (L + 1) * S;
+
+    estimate->num_clauses = 2 * (n * S + 2 * S) // positions initiale et finale : un littéral par clause
+                            + 2 * (L + 1)       // unicité : Or et AtMost par position
+                            + n                 // chemin simple : un AtMost par nœud
+                            + (L + 1) * 2 * S   // pile bien formée : S cellules et S hauteurs par position
+                            + L * S * S;        // cadre de pile : un couple de hauteurs par position
+
+    // Cadre de pile : les couples (h, h2) voisins recopient min(h, h2) + 1 cellules, 4 littéraux chacune
+    uint64_t frame_cells = S * (S + 1) / 2 + S * (S - 1);
+    estimate->num_literals = 2 * (n * S + 2 * S)                     // positions initiale et finale
+                             + (L + 1) * 2 * n * S                   // unicité
+                             + (L + 1) * n * S                       // chemin simple
+                             + (L + 1) * (2 * S + S * (n + 2 * S))   // pile bien formée
+                             + L * (2 * n * S * S + 4 * frame_cells); // cadre de pile
+}
+
+void tn_estimate_reduction(uint64_t num_nodes, uint64_t num_edges, uint64_t num_actions, int length, int stack_size,
+                           tn_size_estimate *estimate)
+{
+    uint64_t n = num_nodes;
+    uint64_t L = length;
+    uint64_t S = stack_size;
+    estimate_without_transitions(n, L, S, estimate);
+    estimate->num_clauses += n * L * S;
+
+    // Chaque action possible en (u, pos, h) : y avant, y après et un x par successeur ; toutes les actions
+    // sont supposées possibles à toutes les hauteurs
+    uint64_t actions_times_successors = n == 0 ? 0 : num_actions * num_edges / n;
+    estimate->num_literals += L * S * (n + 2 * num_actions + actions_times_successors);
+}
+
+void tn_view_estimate_reduction(const tn_view view, int length, tn_size_estimate *estimate)
+{
+    uint64_t n = tn_view_num_nodes(view);
+    uint64_t L = length;
+    uint64_t S = get_stack_size(length);
+    estimate_without_transitions(n, L, S, estimate);
+    estimate->num_clauses += n * L * S;
+
+    // Par (u, pos) : un x par hauteur, et 2 + deg(u) littéraux par action possible à cette hauteur ; T est
+    // possible à toutes les hauteurs, PUSH sauf au sommet, POP sauf au fond
+    uint64_t literals = n * S;
+    for (int u = 0; u < (int)n; u++)
+    {
+        int num_successors;
+        tn_view_successors(view, u, &num_successors);
+        if (num_successors == 0)
+            continue;
+        // Bits de tn_graph_action_bit : T sur les bits 0 et 1, PUSH sur 2 à 5, POP sur 6 à 9
+        unsigned actions = tn_view_node_actions(view, u);
+        uint64_t choices = count_bits(actions & 0x3u) * S + count_bits(actions & 0x3fcu) * (S - 1);
+        literals += choices * (2 + (uint64_t)num_successors);
+    }
+    estimate->num_literals += L * literals;
+}
+
+bool tn_estimate_within(const tn_size_estimate *estimate, const tn_size_estimate *budget)
+{
+    return (budget->num_variables == 0 || estimate->num_variables <= budget->num_variables) &&
+           (budget->num_clauses == 0 || estimate->num_clauses <= budget->num_clauses) &&
+           (budget->num_literals == 0 || estimate->num_literals <= budget->num_literals);
+}
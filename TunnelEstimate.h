@@ -0,0 +1,61 @@
+#ifndef TUNNEL_ESTIMATE_H
+#define TUNNEL_ESTIMATE_H
+
+#include "TunnelView.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file TunnelEstimate.h
+ * @brief Size of the reduction predicted from the size of the network, without building anything.
+ *
+ * The counts follow the constructors of TunnelReduction.c: variables and clauses are exact (with the same
+ * conventions as tn_stats_formula_size), literals count the occurrences of variables before Z3 shares the
+ * identical sub-formulas, so they bound the measured count from above. All the arithmetic is on 64 bits.
+ */
+
+/**
+ * @brief Predicted size of a reduction.
+ */
+typedef struct
+{
+    uint64_t num_variables; ///< Propositional variables x and y.
+    uint64_t num_clauses;   ///< Conjuncts once the top-level conjunctions are flattened.
+    uint64_t num_literals;  ///< Occurrences of variables, before sharing.
+} tn_size_estimate;
+
+/**
+ * @brief Predicts the size of tn_reduction from the size of a network alone.
+ *
+ * The actions and the edges are assumed spread evenly over the nodes: tn_view_estimate_reduction is exact on
+ * the transitions when a view is at hand.
+ *
+ * @param num_nodes The number of nodes.
+ * @param num_edges The number of edges.
+ * @param num_actions The number of actions, over all the nodes.
+ * @param length The length of the sought path.
+ * @param stack_size The number of cells of the stack (get_stack_size(length)).
+ * @param estimate The predicted size.
+ */
+void tn_estimate_reduction(uint64_t num_nodes, uint64_t num_edges, uint64_t num_actions, int length, int stack_size,
+                           tn_size_estimate *estimate);
+
+/**
+ * @brief Predicts the size of tn_reduction on @p view, in time linear in the number of nodes.
+ *
+ * @param view A view of the network.
+ * @param length The length of the sought path.
+ * @param estimate The predicted size.
+ */
+void tn_view_estimate_reduction(const tn_view view, int length, tn_size_estimate *estimate);
+
+/**
+ * @brief Whether @p estimate fits in @p budget. A field of @p budget set to 0 is not bounded.
+ *
+ * @param estimate A predicted size.
+ * @param budget The budget.
+ * @return bool
+ */
+bool tn_estimate_within(const tn_size_estimate *estimate, const tn_size_estimate *budget);
+
+#endif
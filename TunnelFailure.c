@@ -0,0 +1,201 @@
+#include "TunnelFailure.h"
+#include "TunnelEncoding.h"
+#include "TunnelReduction.h"
+#include "Z3Tools.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+struct tn_failure_analysis_s
+{
+    Z3_context ctx;
+    TunnelNetwork network;
+    int num_nodes;
+    int max_length;
+    Z3_solver solver;
+
+    // Hypothèses du dernier scénario : assumptions[i] provient de failures[owner[i]]
+    Z3_ast *assumptions;
+    int *owner;
+    int num_assumptions;
+    int max_assumptions;
+    tn_failure *failures;
+    int num_failures;
+};
+
+tn_failure tn_failure_node(int node)
+{
+    tn_failure failure = {node, -1, -1};
+    return failure;
+}
+
+tn_failure tn_failure_edge(int source, int target)
+{
+    tn_failure failure = {-1, source, target};
+    return failure;
+}
+
+// Littéral activant la réduction de longueur length (copie length du chemin)
+static Z3_ast length_guard(Z3_context ctx, int length)
+{
+    char name[40];
+    snprintf(name, 40, "failure length %d", length);
+    return mk_bool_var(ctx, name);
+}
+
+tn_failure_analysis tn_failure_analysis_create(Z3_context ctx, const TunnelNetwork network, int max_length)
+{
+    tn_failure_analysis analysis = malloc(sizeof(struct tn_failure_analysis_s));
+    analysis->ctx = ctx;
+    analysis->network = network;
+    analysis->num_nodes = tn_get_num_nodes(network);
+    analysis->max_length = max_length;
+    analysis->solver = Z3_mk_solver(ctx);
+    Z3_solver_inc_ref(ctx, analysis->solver);
+
+    // Les cores doivent être minimaux pour désigner les pannes vraiment responsables
+    Z3_params params = Z3_mk_params(ctx);
+    Z3_params_inc_ref(ctx, params);
+    Z3_params_set_bool(ctx, params, Z3_mk_string_symbol(ctx, "core.minimize"), true);
+    Z3_solver_set_params(ctx, analysis->solver, params);
+    Z3_params_dec_ref(ctx, params);
+
+    // Un tunnel d'une des longueurs 1..max_length : OR des gardes, chaque garde activant sa réduction
+    int s = tn_get_initial(network);
+    int d = tn_get_final(network);
+    Z3_ast *guards = malloc((max_length > 0 ? max_length : 1) * sizeof(Z3_ast));
+    for (int length = 1; length <= max_length; length++)
+    {
+        guards[length - 1] = length_guard(ctx, length);
+        Z3_ast reduction = tn_guarded_reduction_copy(ctx, network, length, s, d, length);
+        if (reduction == NULL)
+        {
+            // Encodage arrêté par la limite de mémoire : pas d'analyse
+            free(guards);
+            Z3_solver_dec_ref(ctx, analysis->solver);
+            free(analysis);
+            return NULL;
+        }
+        Z3_solver_assert(ctx, analysis->solver, Z3_mk_implies(ctx, guards[length - 1], reduction));
+    }
+    Z3_solver_assert(ctx, analysis->solver, Z3_mk_or(ctx, max_length, guards));
+    free(guards);
+
+    analysis->max_assumptions = 2 * analysis->num_nodes;
+    analysis->assumptions = malloc(analysis->max_assumptions * sizeof(Z3_ast));
+    analysis->owner = malloc(analysis->max_assumptions * sizeof(int));
+    analysis->num_assumptions = 0;
+    analysis->failures = NULL;
+    analysis->num_failures = 0;
+    return analysis;
+}
+
+void tn_failure_analysis_delete(tn_failure_analysis analysis)
+{
+    Z3_solver_dec_ref(analysis->ctx, analysis->solver);
+    free(analysis->failures);
+    free(analysis->owner);
+    free(analysis->assumptions);
+    free(analysis);
+}
+
+// Ajoute l'hypothèse "l'arête u -> v est en panne", si l'arête existe
+static void add_edge_assumption(tn_failure_analysis analysis, int u, int v, int owner)
+{
+    if (!tn_is_edge(analysis->network, u, v))
+        return;
+    if (analysis->num_assumptions == analysis->max_assumptions)
+    {
+        analysis->max_assumptions *= 2;
+        analysis->assumptions = realloc(analysis->assumptions, analysis->max_assumptions * sizeof(Z3_ast));
+        analysis->owner = realloc(analysis->owner, analysis->max_assumptions * sizeof(int));
+    }
+    analysis->assumptions[analysis->num_assumptions] = Z3_mk_not(analysis->ctx, tn_edge_enable_variable(analysis->ctx, u, v));
+    analysis->owner[analysis->num_assumptions] = owner;
+    analysis->num_assumptions++;
+}
+
+Z3_lbool tn_failure_check(tn_failure_analysis analysis, int num_failures, const tn_failure *failures)
+{
+    analysis->num_assumptions = 0;
+
+    // La panne d'un nœud est celle de toutes ses arêtes entrantes et sortantes
+    for (int i = 0; i < num_failures; i++)
+    {
+        if (failures[i].node < 0)
+        {
+            add_edge_assumption(analysis, failures[i].source, failures[i].target, i);
+            continue;
+        }
+        for (int other = 0; other < analysis->num_nodes; other++)
+        {
+            add_edge_assumption(analysis, failures[i].node, other, i);
+            if (other != failures[i].node)
+                add_edge_assumption(analysis, other, failures[i].node, i);
+        }
+    }
+
+    free(analysis->failures);
+    analysis->failures = malloc((num_failures > 0 ? num_failures : 1) * sizeof(tn_failure));
+    for (int i = 0; i < num_failures; i++)
+        analysis->failures[i] = failures[i];
+    analysis->num_failures = num_failures;
+
+    return Z3_solver_check_assumptions(analysis->ctx, analysis->solver, analysis->num_assumptions, analysis->assumptions);
+}
+
+int tn_failure_get_core(const tn_failure_analysis analysis, tn_failure *core)
+{
+    Z3_context ctx = analysis->ctx;
+    Z3_ast_vector unsat_core = Z3_solver_get_unsat_core(ctx, analysis->solver);
+    Z3_ast_vector_inc_ref(ctx, unsat_core);
+
+    bool *in_core = calloc(analysis->num_failures > 0 ? analysis->num_failures : 1, sizeof(bool));
+    unsigned size = Z3_ast_vector_size(ctx, unsat_core);
+    for (unsigned i = 0; i < size; i++)
+    {
+        Z3_ast literal = Z3_ast_vector_get(ctx, unsat_core, i);
+        for (int a = 0; a < analysis->num_assumptions; a++)
+            if (Z3_is_eq_ast(ctx, literal, analysis->assumptions[a]))
+                in_core[analysis->owner[a]] = true;
+    }
+
+    int n = 0;
+    for (int i = 0; i < analysis->num_failures; i++)
+        if (in_core[i])
+            core[n++] = analysis->failures[i];
+
+    free(in_core);
+    Z3_ast_vector_dec_ref(ctx, unsat_core);
+    return n;
+}
+
+int tn_failure_critical(tn_failure_analysis analysis, tn_failure *critical)
+{
+    Z3_context ctx = analysis->ctx;
+    if (tn_failure_check(analysis, 0, NULL) != Z3_L_TRUE)
+        return -1;
+
+    // Un tunnel qui survit sans panne : seuls ses nœuds et arêtes peuvent être critiques
+    Z3_model model = Z3_solver_get_model(ctx, analysis->solver);
+    Z3_model_inc_ref(ctx, model);
+    int length = 1;
+    while (length < analysis->max_length && !value_of_var_in_model(ctx, model, length_guard(ctx, length)))
+        length++;
+    tn_step *path = malloc(length * sizeof(tn_step));
+    tn_get_path_from_model_copy(ctx, model, analysis->network, length, length, path);
+    Z3_model_dec_ref(ctx, model);
+
+    int n = 0;
+    for (int pos = 0; pos < length; pos++)
+    {
+        tn_failure candidates[2] = {tn_failure_edge(path[pos].source, path[pos].target), tn_failure_node(path[pos].target)};
+        // Le dernier nœud est d : sa panne casse trivialement tous les tunnels
+        int num_candidates = pos + 1 < length ? 2 : 1;
+        for (int c = 0; c < num_candidates; c++)
+            if (tn_failure_check(analysis, 1, &candidates[c]) == Z3_L_FALSE)
+                critical[n++] = candidates[c];
+    }
+
+    free(path);
+    return n;
+}
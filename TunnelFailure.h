@@ -0,0 +1,95 @@
+#ifndef TUNNEL_FAILURE_H
+#define TUNNEL_FAILURE_H
+
+#include "TunnelNetwork.h"
+#include <z3.h>
+
+/**
+ * @file TunnelFailure.h
+ * @brief What-if analysis of link and node failures on the tunnels from the initial to the final node.
+ *
+ * The reductions of every length up to a bound are built once, with each edge guarded by its enable literal
+ * (tn_edge_enable_variable). A failure scenario is then a set of assumptions on a single solver, and the unsat
+ * core of a scenario that breaks all tunnels tells which of its failures are responsible.
+ *
+ * The assumptions of the last scenario are kept without references until tn_failure_get_core compares the core
+ * with them, so the analysis needs a context created with Z3_mk_context (Z3_mk_context_rc is not supported).
+ */
+
+/**
+ * @brief A failure: the node @p node if it is non-negative, the edge @p source -> @p target otherwise.
+ */
+typedef struct
+{
+    int node;
+    int source;
+    int target;
+} tn_failure;
+
+typedef struct tn_failure_analysis_s *tn_failure_analysis;
+
+/**
+ * @brief Creates the failure of a node.
+ *
+ * @param node A node.
+ * @return tn_failure
+ */
+tn_failure tn_failure_node(int node);
+
+/**
+ * @brief Creates the failure of an edge.
+ *
+ * @param source The source of the edge.
+ * @param target The target of the edge.
+ * @return tn_failure
+ */
+tn_failure tn_failure_edge(int source, int target);
+
+/**
+ * @brief Builds the guarded reductions of length 1 to @p max_length in a new solver.
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork.
+ * @param max_length The maximal length of the tunnels.
+ * @return tn_failure_analysis NULL if the memory limit stopped the encoding.
+ */
+tn_failure_analysis tn_failure_analysis_create(Z3_context ctx, const TunnelNetwork network, int max_length);
+
+/**
+ * @brief Frees the analysis (not the context nor the network).
+ *
+ * @param analysis An analysis.
+ */
+void tn_failure_analysis_delete(tn_failure_analysis analysis);
+
+/**
+ * @brief Checks whether a tunnel survives a failure scenario.
+ *
+ * @param analysis An analysis.
+ * @param num_failures The number of failures of the scenario.
+ * @param failures The failures of the scenario.
+ * @return Z3_lbool Z3_L_TRUE if a tunnel survives, Z3_L_FALSE if all tunnels are broken, Z3_L_UNDEF if unknown.
+ */
+Z3_lbool tn_failure_check(tn_failure_analysis analysis, int num_failures, const tn_failure *failures);
+
+/**
+ * @brief After tn_failure_check returned Z3_L_FALSE, the failures of the scenario that suffice to break all tunnels.
+ *
+ * @param analysis An analysis.
+ * @param core An array of size at least the number of failures of the last scenario.
+ * @return int The number of failures written in @p core.
+ */
+int tn_failure_get_core(const tn_failure_analysis analysis, tn_failure *core);
+
+/**
+ * @brief Lists the single failures (inner nodes and edges) that break all tunnels.
+ *
+ * Only the nodes and edges of one surviving tunnel are checked: any other single failure keeps that tunnel.
+ *
+ * @param analysis An analysis.
+ * @param critical An array of size at least 2 * max_length.
+ * @return int The number of critical failures written in @p critical, or -1 if there is no tunnel at all.
+ */
+int tn_failure_critical(tn_failure_analysis analysis, tn_failure *critical);
+
+#endif
@@ -0,0 +1,187 @@
+#include "TunnelFuzz.h"
+#include "TunnelCommon.h"
+#include "TunnelEncoding.h"
+#include "TunnelSearch.h"
+#include "TunnelSession.h"
+#include "TunnelValidator.h"
+#include "TunnelView.h"
+#include "stdlib.h"
+#include "string.h"
+
+#define NUM_ENGINES 4
+
+static const char *engine_names[NUM_ENGINES] = {"search", "fresh", "session", "parallel"};
+
+// ===== GÉNÉRATION =====
+
+tn_graph tn_fuzz_random_graph(unsigned seed, int max_nodes)
+{
+    unsigned state = seed * 2654435761u + 1;
+    int num_nodes = 2 + tn_next_random(&state) % (max_nodes - 1);
+    double edge_density = 0.15 + 0.35 * tn_random_unit(&state);
+    static const double push_pop_densities[] = {0.0, 0.1, 0.25, 0.5};
+    double push_pop_density = push_pop_densities[tn_next_random(&state) % 4];
+
+    unsigned *actions = calloc(num_nodes, sizeof(unsigned));
+    for (int u = 0; u < num_nodes; u++)
+    {
+        if (tn_random_unit(&state) < 0.6)
+            actions[u] |= tn_graph_action_bit(transmit_4);
+        if (tn_random_unit(&state) < 0.4)
+            actions[u] |= tn_graph_action_bit(transmit_6);
+        for (int a = 2; a < TN_NUM_ACTIONS; a++)
+            if (tn_random_unit(&state) < push_pop_density)
+                actions[u] |= tn_graph_action_bit(tn_all_actions[a]);
+    }
+
+    int *edges = malloc(2 * num_nodes * num_nodes * sizeof(int));
+    int num_edges = 0;
+    for (int u = 0; u < num_nodes; u++)
+        for (int v = 0; v < num_nodes; v++)
+            if (u != v && tn_random_unit(&state) < edge_density)
+            {
+                edges[2 * num_edges] = u;
+                edges[2 * num_edges + 1] = v;
+                num_edges++;
+            }
+
+    tn_graph graph = tn_graph_create(num_nodes, NULL, actions, num_edges, edges, 0, num_nodes - 1);
+    free(edges);
+    free(actions);
+    return graph;
+}
+
+// ===== RÉFÉRENCE : RECHERCHE EXHAUSTIVE =====
+
+static int search_shortest(tn_view view, int source, int target, int max_length, tn_step *path)
+{
+    for (int length = 1; length <= max_length; length++)
+        if (tn_view_search_path(view, source, target, length, 0, path) == tn_search_found)
+            return length;
+    return 0;
+}
+
+// ===== MOTEURS SAT =====
+
+static int fresh_shortest(tn_view view, int source, int target, int max_length, tn_step *path)
+{
+    for (int length = 1; length <= max_length; length++)
+    {
+        Z3_config cfg = Z3_mk_config();
+        Z3_context ctx = Z3_mk_context(cfg);
+        Z3_del_config(cfg);
+        Z3_solver solver = Z3_mk_solver(ctx);
+        Z3_solver_inc_ref(ctx, solver);
+        Z3_ast body = tn_view_reduction_body_copy(ctx, view, 0, length);
+        if (body == NULL)
+        {
+            // Encodage arrêté par la limite de mémoire : ni chemin ni absence de chemin
+            Z3_solver_dec_ref(ctx, solver);
+            Z3_del_context(ctx);
+            return -1;
+        }
+        Z3_solver_assert(ctx, solver, body);
+        Z3_solver_assert(ctx, solver, tn_view_endpoints_copy(ctx, view, 0, source, target, length));
+        bool sat = Z3_solver_check(ctx, solver) == Z3_L_TRUE;
+        if (sat)
+        {
+            Z3_model model = Z3_solver_get_model(ctx, solver);
+            Z3_model_inc_ref(ctx, model);
+            tn_view_get_path_from_model_copy(ctx, model, view, 0, length, path);
+            Z3_model_dec_ref(ctx, model);
+        }
+        Z3_solver_dec_ref(ctx, solver);
+        Z3_del_context(ctx);
+        if (sat)
+            return length;
+    }
+    return 0;
+}
+
+static int session_shortest(tn_session session, int source, int target, int max_length, tn_step *path)
+{
+    int length = 0;
+    return tn_session_solve(session, source, target, max_length, path, &length) == tn_session_sat ? length : 0;
+}
+
+// ===== HARNAIS =====
+
+int tn_fuzz(unsigned seed, int num_cases, int max_nodes, int max_length, FILE *out)
+{
+    double times[NUM_ENGINES] = {0};
+    int failures = 0;
+    int num_queries = 0;
+    int num_sat = 0;
+    tn_step *path = malloc(max_length * sizeof(tn_step));
+
+    for (int c = 0; c < num_cases; c++)
+    {
+        unsigned case_seed = seed + c;
+        tn_graph graph = tn_fuzz_random_graph(case_seed, max_nodes);
+        tn_view view = tn_view_from_graph(graph);
+        tn_session session = tn_session_from_graph(graph);
+        tn_session parallel = tn_session_from_graph(graph);
+        tn_session_set_num_threads(parallel, 3);
+        int num_nodes = tn_graph_num_nodes(graph);
+
+        // Les extrémités du réseau, puis deux couples au hasard
+        unsigned state = case_seed * 40503u + 7;
+        for (int q = 0; q < 3; q++)
+        {
+            int source = q == 0 ? tn_graph_initial(graph) : (int)(tn_next_random(&state) % num_nodes);
+            int target = q == 0 ? tn_graph_final(graph) : (int)(tn_next_random(&state) % num_nodes);
+            int lengths[NUM_ENGINES];
+            for (int e = 0; e < NUM_ENGINES; e++)
+            {
+                double start = tn_now();
+                switch (e)
+                {
+                case 0:
+                    lengths[e] = search_shortest(view, source, target, max_length, path);
+                    break;
+                case 1:
+                    lengths[e] = fresh_shortest(view, source, target, max_length, path);
+                    break;
+                case 2:
+                    lengths[e] = session_shortest(session, source, target, max_length, path);
+                    break;
+                default:
+                    lengths[e] = session_shortest(parallel, source, target, max_length, path);
+                    break;
+                }
+                times[e] += tn_now() - start;
+
+                if (lengths[e] > 0)
+                {
+                    tn_path_check check = tn_view_check_path(view, source, target, lengths[e], path);
+                    if (check.error != tn_path_valid)
+                    {
+                        fprintf(out, "case %u (%d -> %d): %s returned an invalid path at step %d: %s\n", case_seed, source,
+                                target, engine_names[e], check.pos, tn_path_error_message(check.error));
+                        failures++;
+                    }
+                }
+                if (lengths[e] != lengths[0])
+                {
+                    fprintf(out, "case %u (%d -> %d): %s finds length %d, search finds %d\n", case_seed, source, target,
+                            engine_names[e], lengths[e], lengths[0]);
+                    failures++;
+                }
+            }
+            num_queries++;
+            if (lengths[0] > 0)
+                num_sat++;
+        }
+
+        tn_session_close(parallel);
+        tn_session_close(session);
+        tn_view_delete(view);
+        tn_graph_delete(graph);
+    }
+
+    fprintf(out, "%d cases, %d queries (%d SAT), %d failures\n", num_cases, num_queries, num_sat, failures);
+    for (int e = 0; e < NUM_ENGINES; e++)
+        fprintf(out, "  %-8s %8.3f s\n", engine_names[e], times[e]);
+    free(path);
+    return failures;
+}
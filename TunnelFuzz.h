@@ -0,0 +1,43 @@
+#ifndef TUNNEL_FUZZ_H
+#define TUNNEL_FUZZ_H
+
+#include "TunnelGraph.h"
+#include <stdio.h>
+
+/**
+ * @file TunnelFuzz.h
+ * @brief Differential testing of the solving engines on random networks.
+ *
+ * Each case is a random network (random size, edge density and density of push/pop actions) generated from
+ * its own seed, so that a failing case can be regenerated with tn_fuzz_random_graph. For a few (source, target)
+ * pairs of each case, every engine looks for a shortest path:
+ *   - search:   exhaustive depth-first search over (node, stack, visited nodes), the reference;
+ *   - fresh:    tn_view_reduction_body_copy and tn_view_endpoints_copy in a new context for each length;
+ *   - session:  tn_session, warm solvers in a reference-counted context;
+ *   - parallel: tn_session with the encoding built on several threads.
+ * The engines must agree on the length found (or on UNSAT), and every path returned must pass
+ * tn_view_check_path. The time spent in each engine is reported at the end.
+ */
+
+/**
+ * @brief The random network of a case.
+ *
+ * @param seed The seed of the case.
+ * @param max_nodes The maximal number of nodes (at least 2).
+ * @return tn_graph The network, to free with tn_graph_delete.
+ */
+tn_graph tn_fuzz_random_graph(unsigned seed, int max_nodes);
+
+/**
+ * @brief Runs @p num_cases random cases and compares the engines.
+ *
+ * @param seed The seed of the first case (case i uses seed + i).
+ * @param num_cases The number of cases.
+ * @param max_nodes The maximal number of nodes of a network (at least 2).
+ * @param max_length The maximal length of the paths looked for.
+ * @param out The stream of the report and of the failures.
+ * @return int The number of failures (disagreements and invalid paths).
+ */
+int tn_fuzz(unsigned seed, int num_cases, int max_nodes, int max_length, FILE *out);
+
+#endif
@@ -0,0 +1,885 @@
+#include "TunnelGraph.h"
+#include "TunnelCommon.h"
+#include "TunnelMemory.h"
+#include "TunnelTrace.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct tn_graph_s
+{
+    int num_nodes;
+    int num_edges;
+    int initial;
+    int final;
+    unsigned *actions;  // masque des actions de chaque nœud
+    int *name_offsets;  // nom du nœud u : names + name_offsets[u]
+    char *names;
+    int *offsets;       // CSR : successeurs de u = targets[offsets[u] .. offsets[u + 1] - 1]
+    int *targets;
+    void *mapping;      // snapshot projeté en mémoire (NULL si les tableaux sont alloués)
+    size_t mapping_size;
+};
+
+// Le bit d'une action dans les masques : son rang dans tn_all_actions
+unsigned tn_graph_action_bit(action act)
+{
+    for (int a = 0; a < TN_NUM_ACTIONS; a++)
+        if (tn_all_actions[a] == act)
+            return 1u << a;
+    return 0;
+}
+
+// ===== LABELS =====
+
+// Flèches UTF-8 : → (transmission), ↑ (push), ↓ (pop)
+static const char *ARROW_TRANSMIT = "\xE2\x86\x92";
+static const char *ARROW_PUSH = "\xE2\x86\x91";
+static const char *ARROW_POP = "\xE2\x86\x93";
+
+static bool is_protocol(char c)
+{
+    return c == '4' || c == '6';
+}
+
+static int protocol_index(char c)
+{
+    return c == '4' ? 0 : 1;
+}
+
+// Une action : "a→a" ou sa forme ASCII "a->a" (transmit_a), "a↑ab" (push_a_b), "ab↓a" (pop_a_b)
+static bool parse_action(const char *s, int length, unsigned *mask)
+{
+    // Le cas "ab↓a" commence par deux protocoles
+    if (length == 6 && is_protocol(s[0]) && is_protocol(s[1]) && memcmp(s + 2, ARROW_POP, 3) == 0 && s[5] == s[0])
+    {
+        *mask |= 1u << (6 + 2 * protocol_index(s[0]) + protocol_index(s[1]));
+        return true;
+    }
+    if (length == 5 && is_protocol(s[0]) && memcmp(s + 1, ARROW_TRANSMIT, 3) == 0 && s[4] == s[0])
+    {
+        *mask |= 1u << protocol_index(s[0]);
+        return true;
+    }
+    if (length == 4 && is_protocol(s[0]) && s[1] == '-' && s[2] == '>' && s[3] == s[0])
+    {
+        *mask |= 1u << protocol_index(s[0]);
+        return true;
+    }
+    if (length == 6 && is_protocol(s[0]) && memcmp(s + 1, ARROW_PUSH, 3) == 0 && s[4] == s[0] && is_protocol(s[5]))
+    {
+        *mask |= 1u << (2 + 2 * protocol_index(s[0]) + protocol_index(s[5]));
+        return true;
+    }
+    return false;
+}
+
+bool tn_graph_parse_label(const char *label, int length, unsigned *mask)
+{
+    *mask = 0;
+    int i = 0;
+    while (i < length)
+    {
+        if (label[i] == ',' || label[i] == ';' || label[i] == ' ' || label[i] == '\n' || label[i] == '\t')
+        {
+            i++;
+            continue;
+        }
+        int start = i;
+        while (i < length && label[i] != ',' && label[i] != ';' && label[i] != ' ' && label[i] != '\n' && label[i] != '\t')
+            i++;
+        if (!parse_action(label + start, i - start, mask))
+            return false;
+    }
+    return true;
+}
+
+const char *tn_graph_action_label(action act)
+{
+    // Les séquences hexadécimales sont coupées pour ne pas absorber le chiffre qui suit
+    static const char *labels[] = {"4\xE2\x86\x92" "4",  "6\xE2\x86\x92" "6",  "4\xE2\x86\x91" "44", "4\xE2\x86\x91" "46",
+                                   "6\xE2\x86\x91" "64", "6\xE2\x86\x91" "66", "44\xE2\x86\x93" "4", "46\xE2\x86\x93" "4",
+                                   "64\xE2\x86\x93" "6", "66\xE2\x86\x93" "6"};
+    for (int a = 0; a < TN_NUM_ACTIONS; a++)
+        if (tn_all_actions[a] == act)
+            return labels[a];
+    return "?";
+}
+
+// ===== LEXER (les tokens sont des morceaux du fichier projeté en mémoire) =====
+
+typedef enum
+{
+    TOKEN_ID,
+    TOKEN_EDGE,
+    TOKEN_SYMBOL,
+    TOKEN_END,
+    TOKEN_ERROR
+} token_kind;
+
+typedef struct
+{
+    token_kind kind;
+    const char *text;
+    int length;
+} token;
+
+typedef struct
+{
+    const char *p;
+    const char *end;
+    int line;
+    token current;
+} lexer;
+
+static bool is_id_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.' ||
+           (unsigned char)c >= 0x80;
+}
+
+static void skip_blanks(lexer *lex)
+{
+    while (lex->p < lex->end)
+    {
+        char c = *lex->p;
+        if (c == '\n')
+        {
+            lex->line++;
+            lex->p++;
+        }
+        else if (c == ' ' || c == '\t' || c == '\r')
+            lex->p++;
+        else if (c == '#' || (c == '/' && lex->p + 1 < lex->end && lex->p[1] == '/'))
+        {
+            while (lex->p < lex->end && *lex->p != '\n')
+                lex->p++;
+        }
+        else if (c == '/' && lex->p + 1 < lex->end && lex->p[1] == '*')
+        {
+            lex->p += 2;
+            while (lex->p + 1 < lex->end && !(lex->p[0] == '*' && lex->p[1] == '/'))
+            {
+                if (*lex->p == '\n')
+                    lex->line++;
+                lex->p++;
+            }
+            lex->p = lex->p + 2 < lex->end ? lex->p + 2 : lex->end;
+        }
+        else
+            return;
+    }
+}
+
+static void next_token(lexer *lex)
+{
+    skip_blanks(lex);
+    token *t = &lex->current;
+    if (lex->p >= lex->end)
+    {
+        t->kind = TOKEN_END;
+        return;
+    }
+
+    const char *start = lex->p;
+    if (*start == '"')
+    {
+        // Chaîne : le token est son contenu, sans les guillemets
+        lex->p++;
+        while (lex->p < lex->end && *lex->p != '"')
+        {
+            if (*lex->p == '\\' && lex->p + 1 < lex->end)
+                lex->p++;
+            if (*lex->p == '\n')
+                lex->line++;
+            lex->p++;
+        }
+        if (lex->p >= lex->end)
+        {
+            t->kind = TOKEN_ERROR;
+            return;
+        }
+        t->kind = TOKEN_ID;
+        t->text = start + 1;
+        t->length = (int)(lex->p - start - 1);
+        lex->p++;
+        return;
+    }
+    if (*start == '-' && lex->p + 1 < lex->end && (lex->p[1] == '>' || lex->p[1] == '-'))
+    {
+        t->kind = TOKEN_EDGE;
+        t->text = start;
+        t->length = 2;
+        lex->p += 2;
+        return;
+    }
+    if (is_id_char(*start) || *start == '-')
+    {
+        lex->p++;
+        while (lex->p < lex->end && is_id_char(*lex->p))
+            lex->p++;
+        t->kind = TOKEN_ID;
+        t->text = start;
+        t->length = (int)(lex->p - start);
+        return;
+    }
+    t->kind = TOKEN_SYMBOL;
+    t->text = start;
+    t->length = 1;
+    lex->p++;
+}
+
+static bool token_is(const token *t, const char *text)
+{
+    int length = (int)strlen(text);
+    return (t->kind == TOKEN_ID || t->kind == TOKEN_SYMBOL) && t->length == length && memcmp(t->text, text, length) == 0;
+}
+
+// ===== TABLE DES NŒUDS (clés = morceaux du fichier, pas de copie) =====
+
+typedef struct
+{
+    int num_nodes;
+    int max_nodes;
+    const char **keys;
+    int *key_lengths;
+    unsigned *actions;
+    int initial;
+    int final;
+
+    int *slots; // table de hachage ouverte : indice du nœud + 1, 0 = libre
+    int num_slots;
+
+    int *edges; // paires (source, cible)
+    int num_edges;
+    int max_edges;
+} builder;
+
+static unsigned hash_key(const char *key, int length)
+{
+    unsigned h = 2166136261u;
+    for (int i = 0; i < length; i++)
+        h = (h ^ (unsigned char)key[i]) * 16777619u;
+    return h;
+}
+
+static void rehash(builder *b)
+{
+    free(b->slots);
+    b->num_slots *= 2;
+    b->slots = calloc(b->num_slots, sizeof(int));
+    for (int n = 0; n < b->num_nodes; n++)
+    {
+        unsigned i = hash_key(b->keys[n], b->key_lengths[n]) & (b->num_slots - 1);
+        while (b->slots[i] != 0)
+            i = (i + 1) & (b->num_slots - 1);
+        b->slots[i] = n + 1;
+    }
+}
+
+// Indice du nœud de nom key, créé s'il n'existe pas
+static int node_index(builder *b, const char *key, int length)
+{
+    unsigned i = hash_key(key, length) & (b->num_slots - 1);
+    while (b->slots[i] != 0)
+    {
+        int n = b->slots[i] - 1;
+        if (b->key_lengths[n] == length && memcmp(b->keys[n], key, length) == 0)
+            return n;
+        i = (i + 1) & (b->num_slots - 1);
+    }
+
+    if (b->num_nodes == b->max_nodes)
+    {
+        b->max_nodes *= 2;
+        b->keys = realloc(b->keys, b->max_nodes * sizeof(const char *));
+        b->key_lengths = realloc(b->key_lengths, b->max_nodes * sizeof(int));
+        b->actions = realloc(b->actions, b->max_nodes * sizeof(unsigned));
+    }
+    int n = b->num_nodes++;
+    b->keys[n] = key;
+    b->key_lengths[n] = length;
+    b->actions[n] = 0;
+    b->slots[i] = n + 1;
+    if (2 * b->num_nodes > b->num_slots)
+        rehash(b);
+    return n;
+}
+
+static void add_edge(builder *b, int source, int target)
+{
+    if (b->num_edges == b->max_edges)
+    {
+        b->max_edges *= 2;
+        b->edges = realloc(b->edges, 2 * b->max_edges * sizeof(int));
+    }
+    b->edges[2 * b->num_edges] = source;
+    b->edges[2 * b->num_edges + 1] = target;
+    b->num_edges++;
+}
+
+// ===== PARSER =====
+
+static bool parse_error(lexer *lex, const char *filename, const char *message)
+{
+    fprintf(stderr, "%s:%d: %s\n", filename, lex->line, message);
+    return false;
+}
+
+// Liste d'attributs [a=b, c=d] ; node < 0 pour les attributs ignorés (arêtes, défauts)
+static bool parse_attributes(lexer *lex, builder *b, int node, const char *filename)
+{
+    while (token_is(&lex->current, "["))
+    {
+        next_token(lex);
+        while (!token_is(&lex->current, "]"))
+        {
+            if (lex->current.kind != TOKEN_ID)
+                return parse_error(lex, filename, "attribute name expected");
+            token name = lex->current;
+            next_token(lex);
+            if (!token_is(&lex->current, "="))
+                return parse_error(lex, filename, "'=' expected");
+            next_token(lex);
+            if (lex->current.kind != TOKEN_ID)
+                return parse_error(lex, filename, "attribute value expected");
+            token value = lex->current;
+            next_token(lex);
+
+            if (node >= 0 && token_is(&name, "label") && !tn_graph_parse_label(value.text, value.length, &b->actions[node]))
+                return parse_error(lex, filename, "invalid action label");
+            if (node >= 0 && token_is(&name, "initial") && token_is(&value, "true"))
+                b->initial = node;
+            if (node >= 0 && token_is(&name, "final") && token_is(&value, "true"))
+                b->final = node;
+
+            if (token_is(&lex->current, ",") || token_is(&lex->current, ";"))
+                next_token(lex);
+        }
+        next_token(lex);
+    }
+    return true;
+}
+
+static bool parse_graph(lexer *lex, builder *b, const char *filename)
+{
+    next_token(lex);
+    if (token_is(&lex->current, "strict"))
+        next_token(lex);
+    if (!token_is(&lex->current, "digraph") && !token_is(&lex->current, "graph"))
+        return parse_error(lex, filename, "'digraph' expected");
+    next_token(lex);
+    if (lex->current.kind == TOKEN_ID)
+        next_token(lex);
+    if (!token_is(&lex->current, "{"))
+        return parse_error(lex, filename, "'{' expected");
+    next_token(lex);
+
+    while (!token_is(&lex->current, "}"))
+    {
+        if (lex->current.kind == TOKEN_END || lex->current.kind == TOKEN_ERROR)
+            return parse_error(lex, filename, "unexpected end of file");
+        if (token_is(&lex->current, ";"))
+        {
+            next_token(lex);
+            continue;
+        }
+        if (lex->current.kind != TOKEN_ID)
+            return parse_error(lex, filename, "statement expected");
+
+        // Attributs par défaut : node [...], edge [...], graph [...]
+        if (token_is(&lex->current, "node") || token_is(&lex->current, "edge") || token_is(&lex->current, "graph"))
+        {
+            next_token(lex);
+            if (!parse_attributes(lex, b, -1, filename))
+                return false;
+            continue;
+        }
+
+        token first = lex->current;
+        next_token(lex);
+
+        // Attribut du graphe : a = b
+        if (token_is(&lex->current, "="))
+        {
+            next_token(lex);
+            next_token(lex);
+            continue;
+        }
+
+        int node = node_index(b, first.text, first.length);
+        if (lex->current.kind != TOKEN_EDGE)
+        {
+            if (!parse_attributes(lex, b, node, filename))
+                return false;
+            continue;
+        }
+
+        // Chaîne d'arêtes a -> b -> c [...]
+        while (lex->current.kind == TOKEN_EDGE)
+        {
+            next_token(lex);
+            if (lex->current.kind != TOKEN_ID)
+                return parse_error(lex, filename, "node expected after '->'");
+            int target = node_index(b, lex->current.text, lex->current.length);
+            add_edge(b, node, target);
+            node = target;
+            next_token(lex);
+        }
+        if (!parse_attributes(lex, b, -1, filename))
+            return false;
+    }
+    return true;
+}
+
+static int compare_ints(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static size_t names_size(const tn_graph graph)
+{
+    if (graph->num_nodes == 0)
+        return 0;
+    int last = graph->num_nodes - 1;
+    return graph->name_offsets[last] + strlen(graph->names + graph->name_offsets[last]) + 1;
+}
+
+// Taille des tableaux du graphe (ou de la projection du snapshot), pour TunnelMemory
+static long graph_memory(const tn_graph graph)
+{
+    if (graph->mapping != NULL)
+        return (long)(sizeof(struct tn_graph_s) + graph->mapping_size);
+    return (long)(sizeof(struct tn_graph_s) + (3 * (size_t)graph->num_nodes + 1 + graph->num_edges) * sizeof(int) +
+                  names_size(graph));
+}
+
+// Construit le graphe final : arène des noms et CSR trié sans doublons
+static tn_graph build_graph(builder *b)
+{
+    tn_graph graph = malloc(sizeof(struct tn_graph_s));
+    int n = b->num_nodes;
+    graph->num_nodes = n;
+    graph->initial = b->initial >= 0 ? b->initial : 0;
+    graph->final = b->final >= 0 ? b->final : n - 1;
+    graph->actions = malloc((n > 0 ? n : 1) * sizeof(unsigned));
+    memcpy(graph->actions, b->actions, (size_t)n * sizeof(unsigned));
+
+    size_t names_size = 0;
+    for (int u = 0; u < n; u++)
+        names_size += b->key_lengths[u] + 1;
+    graph->names = malloc(names_size > 0 ? names_size : 1);
+    graph->name_offsets = malloc((n > 0 ? n : 1) * sizeof(int));
+    size_t offset = 0;
+    for (int u = 0; u < n; u++)
+    {
+        graph->name_offsets[u] = (int)offset;
+        memcpy(graph->names + offset, b->keys[u], b->key_lengths[u]);
+        graph->names[offset + b->key_lengths[u]] = '\0';
+        offset += b->key_lengths[u] + 1;
+    }
+
+    graph->offsets = calloc(n + 1, sizeof(int));
+    for (int e = 0; e < b->num_edges; e++)
+        graph->offsets[b->edges[2 * e] + 1]++;
+    for (int u = 0; u < n; u++)
+        graph->offsets[u + 1] += graph->offsets[u];
+
+    int *fill = malloc((n > 0 ? n : 1) * sizeof(int));
+    memcpy(fill, graph->offsets, n * sizeof(int));
+    graph->targets = malloc((b->num_edges > 0 ? b->num_edges : 1) * sizeof(int));
+    for (int e = 0; e < b->num_edges; e++)
+        graph->targets[fill[b->edges[2 * e]]++] = b->edges[2 * e + 1];
+    free(fill);
+
+    // Tri de chaque liste de successeurs et suppression des arêtes en double
+    int num_edges = 0;
+    for (int u = 0; u < n; u++)
+    {
+        int first = graph->offsets[u];
+        int last = graph->offsets[u + 1];
+        qsort(graph->targets + first, last - first, sizeof(int), compare_ints);
+        graph->offsets[u] = num_edges;
+        for (int e = first; e < last; e++)
+            if (e == first || graph->targets[e] != graph->targets[e - 1])
+                graph->targets[num_edges++] = graph->targets[e];
+    }
+    graph->offsets[n] = num_edges;
+    graph->num_edges = num_edges;
+    graph->mapping = NULL;
+    graph->mapping_size = 0;
+    tn_memory_track(graph_memory(graph));
+    return graph;
+}
+
+static tn_graph load_dot(const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        perror(filename);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        fprintf(stderr, "%s: empty or unreadable file\n", filename);
+        close(fd);
+        return NULL;
+    }
+    const char *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        perror(filename);
+        return NULL;
+    }
+    madvise((void *)data, st.st_size, MADV_SEQUENTIAL);
+
+    builder b;
+    b.num_nodes = 0;
+    b.max_nodes = 1024;
+    b.keys = malloc(b.max_nodes * sizeof(const char *));
+    b.key_lengths = malloc(b.max_nodes * sizeof(int));
+    b.actions = malloc(b.max_nodes * sizeof(unsigned));
+    b.initial = -1;
+    b.final = -1;
+    b.num_slots = 4096;
+    b.slots = calloc(b.num_slots, sizeof(int));
+    b.num_edges = 0;
+    b.max_edges = 4096;
+    b.edges = malloc(2 * b.max_edges * sizeof(int));
+
+    lexer lex = {data, data + st.st_size, 1, {TOKEN_END, NULL, 0}};
+    tn_graph graph = NULL;
+    if (parse_graph(&lex, &b, filename))
+    {
+        if (b.num_nodes == 0)
+            fprintf(stderr, "%s: no node\n", filename);
+        else
+            graph = build_graph(&b);
+    }
+
+    free(b.edges);
+    free(b.slots);
+    free(b.actions);
+    free(b.key_lengths);
+    free(b.keys);
+    munmap((void *)data, st.st_size);
+    return graph;
+}
+
+tn_graph tn_graph_load_dot(const char *filename)
+{
+    tn_trace_span span = tn_trace_begin("parse DOT", "parse");
+    tn_graph graph = load_dot(filename);
+    tn_trace_end(span);
+    tn_memory_phase("load");
+    return graph;
+}
+
+tn_graph tn_graph_create(int num_nodes, const char *const *names, const unsigned *actions, int num_edges, const int *edges,
+                         int initial, int final)
+{
+    // Noms par défaut "n0", "n1", ... dans un tampon temporaire, recopiés par build_graph
+    char *default_names = NULL;
+    if (names == NULL)
+        default_names = malloc((size_t)num_nodes * 12);
+
+    builder b;
+    b.num_nodes = num_nodes;
+    b.keys = malloc((num_nodes > 0 ? num_nodes : 1) * sizeof(const char *));
+    b.key_lengths = malloc((num_nodes > 0 ? num_nodes : 1) * sizeof(int));
+    b.actions = (unsigned *)actions;
+    b.initial = initial;
+    b.final = final;
+    b.edges = (int *)edges;
+    b.num_edges = num_edges;
+    for (int u = 0; u < num_nodes; u++)
+    {
+        if (names == NULL)
+        {
+            b.keys[u] = default_names + (size_t)u * 12;
+            b.key_lengths[u] = snprintf(default_names + (size_t)u * 12, 12, "n%d", u);
+        }
+        else
+        {
+            b.keys[u] = names[u];
+            b.key_lengths[u] = (int)strlen(names[u]);
+        }
+    }
+
+    tn_graph graph = build_graph(&b);
+    free(b.key_lengths);
+    free(b.keys);
+    free(default_names);
+    return graph;
+}
+
+void tn_graph_delete(tn_graph graph)
+{
+    tn_memory_track(-graph_memory(graph));
+    if (graph->mapping != NULL)
+    {
+        munmap(graph->mapping, graph->mapping_size);
+        free(graph);
+        return;
+    }
+    free(graph->targets);
+    free(graph->offsets);
+    free(graph->name_offsets);
+    free(graph->names);
+    free(graph->actions);
+    free(graph);
+}
+
+// ===== DOT =====
+
+bool tn_graph_save_dot(const tn_graph graph, const char *filename)
+{
+    FILE *file = fopen(filename, "w");
+    if (file == NULL)
+    {
+        perror(filename);
+        return false;
+    }
+    fprintf(file, "digraph G {\n");
+    for (int u = 0; u < graph->num_nodes; u++)
+    {
+        fprintf(file, "\"%s\" [label=\"", graph->names + graph->name_offsets[u]);
+        bool first = true;
+        for (int a = 0; a < TN_NUM_ACTIONS; a++)
+            if (graph->actions[u] & (1u << a))
+            {
+                fprintf(file, "%s%s", first ? "" : ",", tn_graph_action_label(tn_all_actions[a]));
+                first = false;
+            }
+        fprintf(file, "\"%s%s]\n", u == graph->initial ? ", initial=true" : "", u == graph->final ? ", final=true" : "");
+    }
+    for (int u = 0; u < graph->num_nodes; u++)
+        for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++)
+            fprintf(file, "\"%s\" -> \"%s\"\n", graph->names + graph->name_offsets[u],
+                    graph->names + graph->name_offsets[graph->targets[e]]);
+    fprintf(file, "}\n");
+    if (fclose(file) != 0)
+    {
+        fprintf(stderr, "%s: cannot write DOT file\n", filename);
+        return false;
+    }
+    return true;
+}
+
+// ===== SNAPSHOT =====
+
+// En-tête du snapshot, suivi de actions[n], name_offsets[n], offsets[n + 1], targets[m] puis des noms
+typedef struct
+{
+    char magic[8];
+    unsigned version;
+    int num_nodes;
+    int num_edges;
+    int initial;
+    int final;
+    unsigned names_size;
+} snapshot_header;
+
+static const char SNAPSHOT_MAGIC[8] = "TNSNAP\0";
+#define SNAPSHOT_VERSION 1
+
+static size_t snapshot_size(int num_nodes, int num_edges, size_t names_size)
+{
+    return sizeof(snapshot_header) + (3 * (size_t)num_nodes + 1 + num_edges) * sizeof(int) + names_size;
+}
+
+bool tn_graph_save_snapshot(const tn_graph graph, const char *filename)
+{
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL)
+    {
+        perror(filename);
+        return false;
+    }
+    int n = graph->num_nodes;
+    snapshot_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.num_nodes = n;
+    header.num_edges = graph->num_edges;
+    header.initial = graph->initial;
+    header.final = graph->final;
+    header.names_size = (unsigned)names_size(graph);
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(graph->actions, sizeof(unsigned), n, file) == (size_t)n &&
+              fwrite(graph->name_offsets, sizeof(int), n, file) == (size_t)n &&
+              fwrite(graph->offsets, sizeof(int), n + 1, file) == (size_t)n + 1 &&
+              fwrite(graph->targets, sizeof(int), graph->num_edges, file) == (size_t)graph->num_edges &&
+              fwrite(graph->names, 1, header.names_size, file) == header.names_size;
+    if (fclose(file) != 0)
+        ok = false;
+    if (!ok)
+        fprintf(stderr, "%s: cannot write snapshot\n", filename);
+    return ok;
+}
+
+// Vérifie les tableaux d'un snapshot dont la taille est cohérente : NULL s'il est valide, l'erreur sinon.
+// Les accesseurs du graphe indexent ces tableaux sans contrôle, un fichier corrompu ne doit pas passer.
+static const char *check_snapshot(const snapshot_header *header)
+{
+    int n = header->num_nodes;
+    int m = header->num_edges;
+    const int *name_offsets = (const int *)((const unsigned *)(header + 1) + n);
+    const int *offsets = name_offsets + n;
+    const int *targets = offsets + n + 1;
+    const char *names = (const char *)(targets + m);
+
+    if (header->initial < 0 || header->initial >= n || header->final < 0 || header->final >= n)
+        return "initial or final node out of range";
+    if (offsets[0] != 0 || offsets[n] != m)
+        return "edge offsets do not cover the edges";
+    for (int u = 0; u < n; u++)
+        if (offsets[u + 1] < offsets[u])
+            return "decreasing edge offsets";
+    for (int e = 0; e < m; e++)
+        if (targets[e] < 0 || targets[e] >= n)
+            return "edge target out of range";
+    for (int u = 0; u < n; u++)
+        if (name_offsets[u] < 0 || (unsigned)name_offsets[u] >= header->names_size)
+            return "node name out of range";
+    if (header->names_size == 0 || names[header->names_size - 1] != '\0')
+        return "unterminated node names";
+    return NULL;
+}
+
+static tn_graph load_snapshot(const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        perror(filename);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(snapshot_header))
+    {
+        fprintf(stderr, "%s: not a snapshot\n", filename);
+        close(fd);
+        return NULL;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        perror(filename);
+        return NULL;
+    }
+
+    const snapshot_header *header = data;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION ||
+        header->num_nodes <= 0 || header->num_edges < 0 ||
+        snapshot_size(header->num_nodes, header->num_edges, header->names_size) != (size_t)st.st_size)
+    {
+        fprintf(stderr, "%s: not a snapshot or wrong version\n", filename);
+        munmap(data, st.st_size);
+        return NULL;
+    }
+    const char *error = check_snapshot(header);
+    if (error != NULL)
+    {
+        fprintf(stderr, "%s: corrupted snapshot: %s\n", filename, error);
+        munmap(data, st.st_size);
+        return NULL;
+    }
+
+    // Les tableaux du graphe pointent directement dans la projection
+    int n = header->num_nodes;
+    tn_graph graph = malloc(sizeof(struct tn_graph_s));
+    graph->num_nodes = n;
+    graph->num_edges = header->num_edges;
+    graph->initial = header->initial;
+    graph->final = header->final;
+    graph->actions = (unsigned *)(header + 1);
+    graph->name_offsets = (int *)(graph->actions + n);
+    graph->offsets = graph->name_offsets + n;
+    graph->targets = graph->offsets + n + 1;
+    graph->names = (char *)(graph->targets + graph->num_edges);
+    graph->mapping = data;
+    graph->mapping_size = st.st_size;
+    tn_memory_track(graph_memory(graph));
+    return graph;
+}
+
+tn_graph tn_graph_load_snapshot(const char *filename)
+{
+    tn_trace_span span = tn_trace_begin("load snapshot", "parse");
+    tn_graph graph = load_snapshot(filename);
+    tn_trace_end(span);
+    tn_memory_phase("load");
+    return graph;
+}
+
+// ===== ACCESSEURS =====
+
+int tn_graph_num_nodes(const tn_graph graph)
+{
+    return graph->num_nodes;
+}
+
+int tn_graph_num_edges(const tn_graph graph)
+{
+    return graph->num_edges;
+}
+
+int tn_graph_initial(const tn_graph graph)
+{
+    return graph->initial;
+}
+
+int tn_graph_final(const tn_graph graph)
+{
+    return graph->final;
+}
+
+const char *tn_graph_node_name(const tn_graph graph, int node)
+{
+    return graph->names + graph->name_offsets[node];
+}
+
+unsigned tn_graph_node_actions(const tn_graph graph, int node)
+{
+    return graph->actions[node];
+}
+
+bool tn_graph_node_has_action(const tn_graph graph, int node, action act)
+{
+    return (graph->actions[node] & tn_graph_action_bit(act)) != 0;
+}
+
+// Recherche dichotomique dans les successeurs triés
+bool tn_graph_is_edge(const tn_graph graph, int source, int target)
+{
+    int low = graph->offsets[source];
+    int high = graph->offsets[source + 1];
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (graph->targets[middle] < target)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low < graph->offsets[source + 1] && graph->targets[low] == target;
+}
+
+const int *tn_graph_successors(const tn_graph graph, int node, int *num_successors)
+{
+    *num_successors = graph->offsets[node + 1] - graph->offsets[node];
+    return graph->targets + graph->offsets[node];
+}
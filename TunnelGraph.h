@@ -0,0 +1,138 @@
+#ifndef TUNNEL_GRAPH_H
+#define TUNNEL_GRAPH_H
+
+#include "TunnelNetwork.h"
+#include <stdbool.h>
+
+/**
+ * @file TunnelGraph.h
+ * @brief Compact read-only tunnel network for very large topologies.
+ *
+ * The nodes are numbered in order of first appearance. Each node has a packed mask of its actions (bit
+ * tn_graph_action_bit(a) for the action a) and the edges are stored in CSR form: the successors of u are
+ * targets[offsets[u]] to targets[offsets[u + 1] - 1], sorted.
+ *
+ * The DOT loader memory-maps the file and tokenizes it in place: tokens are slices of the mapping, node
+ * labels such as "4↑46" or "46↓4" are turned into action masks while reading, and the only allocations are the
+ * node table, the name arena and the edge arrays.
+ *
+ * The initial and final nodes are the ones with the attribute initial=true / final=true, or by default the
+ * first and the last declared nodes.
+ */
+
+typedef struct tn_graph_s *tn_graph;
+
+/**
+ * @brief Loads a TunnelNetwork DOT file.
+ *
+ * @param filename The path of the file.
+ * @return tn_graph The graph, or NULL if the file cannot be read or parsed (a message is printed on stderr).
+ */
+tn_graph tn_graph_load_dot(const char *filename);
+
+/**
+ * @brief Builds a graph from arrays, for generated networks.
+ *
+ * @param num_nodes The number of nodes (at least 1).
+ * @param names The names of the nodes, or NULL for "n0", "n1", ...
+ * @param actions The action mask of each node.
+ * @param num_edges The number of edges.
+ * @param edges The edges, as 2 * @p num_edges integers (source, target); duplicates are removed.
+ * @param initial The initial node.
+ * @param final The final node.
+ * @return tn_graph The graph, to free with tn_graph_delete.
+ */
+tn_graph tn_graph_create(int num_nodes, const char *const *names, const unsigned *actions, int num_edges, const int *edges,
+                         int initial, int final);
+
+/**
+ * @brief Saves a graph as a DOT file readable by tn_graph_load_dot, nodes first and in order, so that the
+ * numbering of the nodes is kept.
+ *
+ * @param graph A graph.
+ * @param filename The path of the file.
+ * @return true on success (a message is printed on stderr otherwise).
+ */
+bool tn_graph_save_dot(const tn_graph graph, const char *filename);
+
+/**
+ * @brief Saves a binary snapshot of a graph: header, action masks, name offsets, CSR arrays and name arena.
+ *
+ * The snapshot is in the byte order of the machine and is meant to be reloaded on the same machine.
+ *
+ * @param graph A graph.
+ * @param filename The path of the snapshot.
+ * @return true on success (a message is printed on stderr otherwise).
+ */
+bool tn_graph_save_snapshot(const tn_graph graph, const char *filename);
+
+/**
+ * @brief Loads a snapshot saved by tn_graph_save_snapshot with a single mmap and no parsing.
+ *
+ * The arrays of the graph point into the read-only mapping, which is released by tn_graph_delete. They are
+ * checked in one pass before use (endpoints, edge offsets and targets, name offsets, terminated name arena), so
+ * that a truncated or corrupted file is rejected instead of read out of bounds.
+ *
+ * @param filename The path of the snapshot.
+ * @return tn_graph The graph, or NULL if the file is not a valid snapshot.
+ */
+tn_graph tn_graph_load_snapshot(const char *filename);
+
+/**
+ * @brief Frees a graph.
+ *
+ * @param graph A graph.
+ */
+void tn_graph_delete(tn_graph graph);
+
+/**
+ * @brief Bit of the action @p act in the action masks.
+ *
+ * @param act An action.
+ * @return unsigned
+ */
+unsigned tn_graph_action_bit(action act);
+
+/**
+ * @brief Parses a node label ("4→4", "4↑46", "46↓4", several actions separated by commas or spaces).
+ *
+ * The transmissions can also be written in ASCII ("4->4", "6->6").
+ *
+ * @param label The label (not necessarily NUL-terminated).
+ * @param length The length of @p label in bytes.
+ * @param mask The action mask of the label.
+ * @return true if the label is well-formed.
+ */
+bool tn_graph_parse_label(const char *label, int length, unsigned *mask);
+
+/**
+ * @brief The label of an action in the syntax of tn_graph_parse_label ("4→4", "4↑46", "46↓4").
+ *
+ * @param act An action.
+ * @return const char* A static string, "?" for an unknown action.
+ */
+const char *tn_graph_action_label(action act);
+
+/**
+ * @brief Accessors. The nodes are the integers 0 to tn_graph_num_nodes(graph) - 1; the names are owned by the graph.
+ */
+int tn_graph_num_nodes(const tn_graph graph);
+int tn_graph_num_edges(const tn_graph graph);
+int tn_graph_initial(const tn_graph graph);
+int tn_graph_final(const tn_graph graph);
+const char *tn_graph_node_name(const tn_graph graph, int node);
+unsigned tn_graph_node_actions(const tn_graph graph, int node);
+bool tn_graph_node_has_action(const tn_graph graph, int node, action act);
+bool tn_graph_is_edge(const tn_graph graph, int source, int target);
+
+/**
+ * @brief The successors of @p node, sorted.
+ *
+ * @param graph A graph.
+ * @param node A node.
+ * @param num_successors The number of successors.
+ * @return const int* The successors, valid as long as the graph.
+ */
+const int *tn_graph_successors(const tn_graph graph, int node, int *num_successors);
+
+#endif
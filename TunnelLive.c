@@ -0,0 +1,207 @@
+#include "TunnelLive.h"
+#include "TunnelCommon.h"
+#include "TunnelEncoding.h"
+#include "TunnelProgress.h"
+#include "TunnelReduction.h"
+#include "TunnelTrace.h"
+#include "Z3Tools.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+struct tn_live_s
+{
+    Z3_context ctx;
+    TunnelNetwork network;
+    int num_nodes;
+    int max_length;
+    Z3_solver solver;
+    Z3_model model;
+    int model_length;
+
+    bool *edges;      // edges[u * num_nodes + v]
+    bool *actions;    // actions[u * TN_NUM_ACTIONS + a] pour tn_all_actions[a]
+    int *generation;  // génération du groupe de transitions actif de chaque nœud
+    bool *dirty;      // le groupe du nœud ne correspond plus à la topologie
+    Z3_ast *assumptions;
+};
+
+// La réduction de longueur length utilise la copie length du chemin
+static Z3_ast length_guard(Z3_context ctx, int length)
+{
+    char name[40];
+    snprintf(name, 40, "live length %d", length);
+    return mk_bool_var(ctx, name);
+}
+
+// Littéral activant le groupe de transitions numéro generation du nœud node
+static Z3_ast group_guard(Z3_context ctx, int node, int generation)
+{
+    char name[60];
+    snprintf(name, 60, "live node %d generation %d", node, generation);
+    return mk_bool_var(ctx, name);
+}
+
+/**
+ * Remplace le groupe de transitions du nœud u : l'ancien littéral est définitivement faux (le solveur peut
+ * oublier ses clauses), le nouveau garde les transitions de u pour toutes les longueurs.
+ */
+static void rebuild_node(tn_live live, int u)
+{
+    Z3_context ctx = live->ctx;
+    int num_nodes = live->num_nodes;
+
+    if (live->generation[u] >= 0)
+        Z3_solver_assert(ctx, live->solver, Z3_mk_not(ctx, group_guard(ctx, u, live->generation[u])));
+    live->generation[u]++;
+
+    int *successors = malloc(num_nodes * sizeof(int));
+    int num_successors = 0;
+    for (int v = 0; v < num_nodes; v++)
+        if (live->edges[u * num_nodes + v])
+            successors[num_successors++] = v;
+
+    action actions[TN_NUM_ACTIONS];
+    int num_actions = 0;
+    for (int a = 0; a < TN_NUM_ACTIONS; a++)
+        if (live->actions[u * TN_NUM_ACTIONS + a])
+            actions[num_actions++] = tn_all_actions[a];
+
+    Z3_ast *parts = malloc(live->max_length * sizeof(Z3_ast));
+    for (int length = 1; length <= live->max_length; length++)
+        parts[length - 1] = tn_node_transitions_copy(ctx, length, u, num_successors, successors, num_actions, actions, length);
+    Z3_solver_assert(ctx, live->solver,
+                     Z3_mk_implies(ctx, group_guard(ctx, u, live->generation[u]), Z3_mk_and(ctx, live->max_length, parts)));
+
+    free(parts);
+    free(successors);
+    live->dirty[u] = false;
+}
+
+tn_live tn_live_create(Z3_context ctx, const TunnelNetwork network, int max_length)
+{
+    tn_live live = malloc(sizeof(struct tn_live_s));
+    int num_nodes = tn_get_num_nodes(network);
+    live->ctx = ctx;
+    live->network = network;
+    live->num_nodes = num_nodes;
+    live->max_length = max_length;
+    live->solver = Z3_mk_solver(ctx);
+    Z3_solver_inc_ref(ctx, live->solver);
+    live->model = NULL;
+    live->model_length = 0;
+
+    live->edges = malloc(num_nodes * num_nodes * sizeof(bool));
+    live->actions = malloc(num_nodes * TN_NUM_ACTIONS * sizeof(bool));
+    live->generation = malloc(num_nodes * sizeof(int));
+    live->dirty = malloc(num_nodes * sizeof(bool));
+    live->assumptions = malloc((num_nodes + 1) * sizeof(Z3_ast));
+    for (int u = 0; u < num_nodes; u++)
+    {
+        for (int v = 0; v < num_nodes; v++)
+            live->edges[u * num_nodes + v] = tn_is_edge(network, u, v);
+        for (int a = 0; a < TN_NUM_ACTIONS; a++)
+            live->actions[u * TN_NUM_ACTIONS + a] = tn_node_has_action(network, u, tn_all_actions[a]);
+        live->generation[u] = -1;
+        live->dirty[u] = true;
+    }
+
+    // Le squelette ne dépend pas de la topologie : il n'est construit qu'une fois
+    int s = tn_get_initial(network);
+    int d = tn_get_final(network);
+    for (int length = 1; length <= max_length; length++)
+    {
+        Z3_ast skeleton = tn_reduction_skeleton_copy(ctx, network, length, s, d, length);
+        if (skeleton == NULL)
+        {
+            // Encodage arrêté par la limite de mémoire
+            tn_live_delete(live);
+            return NULL;
+        }
+        Z3_solver_assert(ctx, live->solver, Z3_mk_implies(ctx, length_guard(ctx, length), skeleton));
+    }
+
+    return live;
+}
+
+void tn_live_delete(tn_live live)
+{
+    if (live->model != NULL)
+        Z3_model_dec_ref(live->ctx, live->model);
+    Z3_solver_dec_ref(live->ctx, live->solver);
+    free(live->assumptions);
+    free(live->dirty);
+    free(live->generation);
+    free(live->actions);
+    free(live->edges);
+    free(live);
+}
+
+// Seul le nœud source de l'arête voit ses transitions changer
+void tn_live_add_edge(tn_live live, int source, int target)
+{
+    if (live->edges[source * live->num_nodes + target])
+        return;
+    live->edges[source * live->num_nodes + target] = true;
+    live->dirty[source] = true;
+}
+
+void tn_live_remove_edge(tn_live live, int source, int target)
+{
+    if (!live->edges[source * live->num_nodes + target])
+        return;
+    live->edges[source * live->num_nodes + target] = false;
+    live->dirty[source] = true;
+}
+
+void tn_live_set_action(tn_live live, int node, action act, bool enabled)
+{
+    for (int a = 0; a < TN_NUM_ACTIONS; a++)
+    {
+        if (tn_all_actions[a] != act || live->actions[node * TN_NUM_ACTIONS + a] == enabled)
+            continue;
+        live->actions[node * TN_NUM_ACTIONS + a] = enabled;
+        live->dirty[node] = true;
+    }
+}
+
+Z3_lbool tn_live_solve(tn_live live, int length)
+{
+    Z3_context ctx = live->ctx;
+
+    // Les changements accumulés depuis la dernière requête ne reconstruisent que les nœuds touchés
+    for (int u = 0; u < live->num_nodes; u++)
+        if (live->dirty[u])
+            rebuild_node(live, u);
+
+    if (live->model != NULL)
+    {
+        Z3_model_dec_ref(ctx, live->model);
+        live->model = NULL;
+    }
+
+    int n = 0;
+    live->assumptions[n++] = length_guard(ctx, length);
+    for (int u = 0; u < live->num_nodes; u++)
+        live->assumptions[n++] = group_guard(ctx, u, live->generation[u]);
+
+    tn_trace_span span = tn_trace_begin("Z3_solver_check_assumptions", "solve");
+    tn_progress_check_begin(ctx, live->solver, length, false);
+    Z3_lbool result = Z3_solver_check_assumptions(ctx, live->solver, n, live->assumptions);
+    tn_progress_check_end(ctx, live->solver, NULL);
+    char *statistics = tn_trace_z3_statistics(ctx, live->solver);
+    tn_trace_end_args(span, statistics);
+    free(statistics);
+    if (result == Z3_L_TRUE)
+    {
+        live->model = Z3_solver_get_model(ctx, live->solver);
+        Z3_model_inc_ref(ctx, live->model);
+        live->model_length = length;
+        tn_progress_best_length(length);
+    }
+    return result;
+}
+
+void tn_live_get_path(const tn_live live, tn_step *path)
+{
+    tn_get_path_from_model_copy(live->ctx, live->model, live->network, live->model_length, live->model_length, path);
+}
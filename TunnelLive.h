@@ -0,0 +1,84 @@
+#ifndef TUNNEL_LIVE_H
+#define TUNNEL_LIVE_H
+
+#include "TunnelNetwork.h"
+#include <stdbool.h>
+#include <z3.h>
+
+/**
+ * @file TunnelLive.h
+ * @brief A reduction kept alive in a solver while the topology changes.
+ *
+ * The nodes, the initial and the final node are fixed. The transitions leaving each node form a clause group
+ * guarded by an activation literal. Changing the edges or the actions of a node retires its group and asserts a
+ * new one at the next query; the rest of the encoding, the solver and its learned clauses are kept.
+ *
+ * The activation literals live as long as the encoding and hold no reference: create the context with
+ * Z3_mk_context. In a context created with Z3_mk_context_rc they would be freed between two queries.
+ */
+
+typedef struct tn_live_s *tn_live;
+
+/**
+ * @brief Builds the reductions of length 1 to @p max_length for the current topology of @p network.
+ *
+ * @param ctx The solver context.
+ * @param network A TunnelNetwork. Its edges and actions are copied, later changes go through tn_live_* functions.
+ * @param max_length The maximal length of the queries.
+ * @return tn_live NULL if the memory limit stopped the encoding.
+ */
+tn_live tn_live_create(Z3_context ctx, const TunnelNetwork network, int max_length);
+
+/**
+ * @brief Frees the live encoding (not the context nor the network).
+ *
+ * @param live A live encoding.
+ */
+void tn_live_delete(tn_live live);
+
+/**
+ * @brief Adds the edge @p source -> @p target.
+ *
+ * @param live A live encoding.
+ * @param source The source of the edge.
+ * @param target The target of the edge.
+ */
+void tn_live_add_edge(tn_live live, int source, int target);
+
+/**
+ * @brief Removes the edge @p source -> @p target.
+ *
+ * @param live A live encoding.
+ * @param source The source of the edge.
+ * @param target The target of the edge.
+ */
+void tn_live_remove_edge(tn_live live, int source, int target);
+
+/**
+ * @brief Gives or takes an action to a node, the live counterpart of tn_node_has_action.
+ *
+ * @param live A live encoding.
+ * @param node A node.
+ * @param act An action.
+ * @param enabled Whether @p node can perform @p act.
+ */
+void tn_live_set_action(tn_live live, int node, action act, bool enabled);
+
+/**
+ * @brief Looks for a valid path of length @p length in the current topology.
+ *
+ * @param live A live encoding.
+ * @param length The length of the path, between 1 and max_length.
+ * @return Z3_lbool
+ */
+Z3_lbool tn_live_solve(tn_live live, int length);
+
+/**
+ * @brief Reads the path found by the last successful tn_live_solve.
+ *
+ * @param live A live encoding.
+ * @param path An array of tn_step of size at least the length of the last query.
+ */
+void tn_live_get_path(const tn_live live, tn_step *path);
+
+#endif
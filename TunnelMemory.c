@@ -0,0 +1,141 @@
+#include "TunnelMemory.h"
+#include "stdlib.h"
+#include <limits.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <stdatomic.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <z3.h>
+
+static atomic_long own_bytes;
+static atomic_size_t limit;
+static _Thread_local bool exceeded; // par thread : chaque encodage est arrêté et signalé séparément
+static FILE *_Atomic report;
+
+#define MB (1024.0 * 1024.0)
+
+// Mémoire résidente courante : deuxième champ de /proc/self/statm, en pages
+static size_t current_rss(void)
+{
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm == NULL)
+        return 0;
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    if (fscanf(statm, "%lu %lu", &size, &resident) != 2)
+        resident = 0;
+    fclose(statm);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+// Pic de mémoire résidente depuis le dernier tn_memory_reset_peak : ligne VmHWM de /proc/self/status, en kB.
+// Sans /proc, c'est le pic du processus (ru_maxrss).
+static size_t peak_rss(void)
+{
+    FILE *status = fopen("/proc/self/status", "r");
+    unsigned long kb = 0;
+    if (status != NULL)
+    {
+        char line[128];
+        while (fgets(line, sizeof(line), status) != NULL)
+            if (sscanf(line, "VmHWM: %lu kB", &kb) == 1)
+                break;
+        fclose(status);
+    }
+    if (kb == 0)
+    {
+        struct rusage self;
+        getrusage(RUSAGE_SELF, &self);
+        kb = (unsigned long)self.ru_maxrss;
+    }
+    return (size_t)kb * 1024;
+}
+
+void tn_memory_read(tn_memory_usage *usage)
+{
+    usage->z3_bytes = (size_t)Z3_get_estimated_alloc_size();
+    long own = atomic_load(&own_bytes);
+    usage->own_bytes = own > 0 ? (size_t)own : 0;
+    usage->rss_bytes = current_rss();
+    usage->peak_rss_bytes = peak_rss();
+}
+
+bool tn_memory_reset_peak(void)
+{
+#ifdef __GLIBC__
+    // Le tas libéré par les mesures précédentes est rendu au système : il ne compte pas dans la suivante
+    malloc_trim(0);
+#endif
+    // "5" remet VmHWM à la mémoire résidente courante (Linux 4.0 et plus)
+    FILE *clear_refs = fopen("/proc/self/clear_refs", "w");
+    if (clear_refs == NULL)
+        return false;
+    bool ok = fputs("5", clear_refs) >= 0;
+    if (fclose(clear_refs) != 0)
+        ok = false;
+    return ok;
+}
+
+void tn_memory_track(long bytes)
+{
+    atomic_fetch_add_explicit(&own_bytes, bytes, memory_order_relaxed);
+}
+
+void tn_memory_set_report(FILE *out)
+{
+    atomic_store(&report, out);
+}
+
+void tn_memory_phase(const char *phase)
+{
+    FILE *out = atomic_load_explicit(&report, memory_order_relaxed);
+    if (out == NULL)
+        return;
+    tn_memory_usage usage;
+    tn_memory_read(&usage);
+    fprintf(out, "[memory] %-36s Z3 %9.1f MB, own %8.1f MB, RSS %9.1f MB (peak %9.1f MB)\n", phase,
+            usage.z3_bytes / MB, usage.own_bytes / MB, usage.rss_bytes / MB, usage.peak_rss_bytes / MB);
+}
+
+void tn_memory_set_limit(size_t bytes)
+{
+    atomic_store(&limit, bytes);
+    exceeded = false;
+
+    // Les solveurs de Z3 abandonnent (Z3_L_UNDEF) au-delà de ce seuil ; c'est un unsigned, plafonné à 4 Go
+    char value[32];
+    snprintf(value, sizeof(value), "%zu", bytes < UINT_MAX ? bytes : (size_t)UINT_MAX);
+    Z3_global_param_set("memory_high_watermark", value);
+}
+
+bool tn_memory_check(void)
+{
+    size_t max = atomic_load_explicit(&limit, memory_order_relaxed);
+    if (max == 0)
+        return true;
+    if (exceeded)
+        return false;
+
+    size_t z3 = (size_t)Z3_get_estimated_alloc_size();
+    long own = atomic_load_explicit(&own_bytes, memory_order_relaxed);
+    size_t used = z3 + (own > 0 ? (size_t)own : 0);
+    if (used <= max)
+        return true;
+
+    exceeded = true;
+    fprintf(stderr, "Memory limit of %.1f MB exceeded while encoding (Z3 %.1f MB, own buffers %.1f MB): encoding aborted\n",
+            max / MB, z3 / MB, own / MB);
+    return false;
+}
+
+bool tn_memory_exceeded(void)
+{
+    return exceeded;
+}
+
+void tn_memory_clear_exceeded(void)
+{
+    exceeded = false;
+}
@@ -0,0 +1,101 @@
+#ifndef TUNNEL_MEMORY_H
+#define TUNNEL_MEMORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @file TunnelMemory.h
+ * @brief Memory accounting per phase of the pipeline, and a hard cap on the memory of the encoding.
+ *
+ * Three figures are followed: the estimate of Z3 (Z3_get_estimated_alloc_size), the buffers of the graphs and
+ * views alive (the largest buffers of this program), and the resident memory of the process with its high-water
+ * mark.
+ *
+ * With a limit set, the encoder checks Z3 plus own buffers between positions and nodes. Once the limit is
+ * exceeded it stops adding constraints, prints an error, and the encoding fails closed: the builders of the
+ * reduction release the incomplete formula and return NULL, which every caller turns into an error or an unknown
+ * answer (tn_session_solve answers tn_session_unknown). The flag behind tn_memory_exceeded belongs to the calling
+ * thread, so concurrent encodings (sessions of a runner, slices of a parallel encoding) do not see each other
+ * stop. The limit is also the high watermark of Z3 (memory_high_watermark, at most 4 GB), past which a solver
+ * check gives up with Z3_L_UNDEF.
+ */
+
+/**
+ * @brief Memory in use, in bytes.
+ */
+typedef struct
+{
+    size_t z3_bytes;  ///< Estimate of Z3 (all contexts).
+    size_t own_bytes; ///< Buffers of the graphs and views alive.
+    size_t rss_bytes; ///< Resident memory of the process.
+    size_t peak_rss_bytes; ///< High-water mark of the resident memory since tn_memory_reset_peak.
+} tn_memory_usage;
+
+/**
+ * @brief Reads the memory in use.
+ *
+ * @param usage The memory in use.
+ */
+void tn_memory_read(tn_memory_usage *usage);
+
+/**
+ * @brief Restarts the high-water mark of the resident memory from the current resident memory, so that
+ * peak_rss_bytes measures one run. Without it, peak_rss_bytes is the peak of the whole process. With glibc, the
+ * freed heap is handed back to the system first (malloc_trim), so that earlier runs weigh as little as possible.
+ *
+ * @return false if the system cannot reset it (no /proc/self/clear_refs): the peak stays that of the process.
+ */
+bool tn_memory_reset_peak(void);
+
+/**
+ * @brief Records that @p bytes bytes of own buffers were allocated (or freed if negative).
+ *
+ * @param bytes The change.
+ */
+void tn_memory_track(long bytes);
+
+/**
+ * @brief Prints the memory in use after each phase on @p out, or stops reporting if NULL.
+ *
+ * @param out The output stream.
+ */
+void tn_memory_set_report(FILE *out);
+
+/**
+ * @brief Reports the memory in use at the end of a phase ("load", "formula_simple_path", "check", ...), if
+ * reporting is on.
+ *
+ * @param phase The name of the phase.
+ */
+void tn_memory_phase(const char *phase);
+
+/**
+ * @brief Sets the cap on Z3 plus own buffers.
+ *
+ * @param bytes The limit, 0 for none.
+ */
+void tn_memory_set_limit(size_t bytes);
+
+/**
+ * @brief Checks the memory against the limit. The first time the calling thread exceeds it, an error is printed
+ * on stderr.
+ *
+ * @return true while under the limit (or without limit).
+ */
+bool tn_memory_check(void);
+
+/**
+ * @brief Tells whether the limit was exceeded by the calling thread since its last tn_memory_clear_exceeded.
+ *
+ * @return true if the last encodings may be incomplete.
+ */
+bool tn_memory_exceeded(void);
+
+/**
+ * @brief Forgets that the calling thread exceeded the limit: each encoding of the reduction starts with it.
+ */
+void tn_memory_clear_exceeded(void);
+
+#endif
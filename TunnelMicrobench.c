@@ -0,0 +1,231 @@
+#include "TunnelMicrobench.h"
+#include "TunnelBench.h"
+#include "TunnelCommon.h"
+#include "TunnelEncoding.h"
+#include "TunnelReduction.h"
+#include "TunnelStats.h"
+#include "TunnelView.h"
+#include "stdlib.h"
+#include "string.h"
+
+#ifdef TN_COUNT_ALLOCATIONS
+#include <stdatomic.h>
+
+// Les appels passent par les fonctions internes de la glibc, dont malloc n'est qu'un alias
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+
+static atomic_ulong num_allocations;
+
+void *malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&num_allocations, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    atomic_fetch_add_explicit(&num_allocations, 1, memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size)
+{
+    atomic_fetch_add_explicit(&num_allocations, 1, memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+
+static long allocations(void)
+{
+    return (long)atomic_load(&num_allocations);
+}
+#else
+static long allocations(void)
+{
+    return -1;
+}
+#endif
+
+// Réseaux fixes : famille, nombre de nœuds et degré
+typedef struct
+{
+    tn_bench_family family;
+    int num_nodes;
+    int degree;
+} fixed_network;
+
+static const fixed_network networks[] = {
+    {tn_bench_grid, 64, 4}, {tn_bench_scale_free, 256, 3}, {tn_bench_dense_mesh, 64, 32}, {tn_bench_island_chain, 128, 4}};
+
+static const int lengths[] = {8, 16};
+
+#define NUM_NETWORKS ((int)(sizeof(networks) / sizeof(networks[0])))
+#define NUM_LENGTHS ((int)(sizeof(lengths) / sizeof(lengths[0])))
+
+typedef enum
+{
+    target_initial_and_final,
+    target_unique_node,
+    target_simple_path,
+    target_valid_transitions,
+    target_path_variable,
+    target_get_path,
+    NUM_TARGETS
+} target;
+
+static const char *target_names[NUM_TARGETS] = {"formula_initial_and_final_positions",
+                                                "formula_unique_node_per_position",
+                                                "formula_simple_path",
+                                                "formula_valid_transitions",
+                                                "tn_path_variable",
+                                                "tn_get_path_from_model"};
+
+// Accumulateur d'une ligne du rapport
+typedef struct
+{
+    double seconds;
+    long literals;
+    long clauses;
+    long allocations;
+    unsigned long long z3_bytes;
+    int calls;
+} sample;
+
+static Z3_context new_context(void)
+{
+    Z3_config cfg = Z3_mk_config();
+    Z3_context ctx = Z3_mk_context(cfg);
+    Z3_del_config(cfg);
+    return ctx;
+}
+
+// Un appel mesuré d'un constructeur de la réduction ou de tn_path_variable, dans un contexte neuf
+static void measure_builder(const tn_view view, target t, int length, sample *s)
+{
+    Z3_context ctx = new_context();
+    int num_nodes = tn_view_num_nodes(view);
+    int stack_size = get_stack_size(length);
+    Z3_ast *vars = NULL;
+    int num_vars = 0;
+
+    long allocs_before = allocations();
+    unsigned long long bytes_before = Z3_get_estimated_alloc_size();
+    double start = tn_now();
+    Z3_ast formula = NULL;
+    if (t == target_path_variable)
+    {
+        vars = malloc((size_t)num_nodes * (length + 1) * stack_size * sizeof(Z3_ast));
+        for (int u = 0; u < num_nodes; u++)
+            for (int pos = 0; pos <= length; pos++)
+                for (int height = 0; height < stack_size; height++)
+                    vars[num_vars++] = tn_path_variable(ctx, u, pos, height);
+    }
+    else
+        formula = tn_view_formula_part_copy(ctx, view, (tn_formula_part)t, 0, length);
+    s->seconds += tn_now() - start;
+    s->z3_bytes += Z3_get_estimated_alloc_size() - bytes_before;
+    if (allocs_before >= 0)
+        s->allocations += allocations() - allocs_before;
+
+    if (t == target_path_variable)
+        s->literals += num_vars;
+    else if (formula != NULL)
+    {
+        tn_formula_size size;
+        tn_stats_formula_size(ctx, formula, &size);
+        s->literals += size.num_literals;
+        s->clauses += size.num_clauses;
+    }
+    // Une partie arrêtée par la limite de mémoire (NULL) ne compte que son temps
+    s->calls++;
+    free(vars);
+    Z3_del_context(ctx);
+}
+
+// Lecture du chemin depuis un modèle : le modèle est calculé une fois, seule la lecture est mesurée
+static bool measure_get_path(const tn_view view, int length, int repetitions, sample *s)
+{
+    Z3_context ctx = new_context();
+    Z3_solver solver = Z3_mk_solver(ctx);
+    Z3_solver_inc_ref(ctx, solver);
+    Z3_ast formula = tn_view_reduction_copy(ctx, view, 0, length);
+    bool sat = false;
+    if (formula != NULL)
+    {
+        Z3_solver_assert(ctx, solver, formula);
+        sat = Z3_solver_check(ctx, solver) == Z3_L_TRUE;
+    }
+    if (sat)
+    {
+        Z3_model model = Z3_solver_get_model(ctx, solver);
+        Z3_model_inc_ref(ctx, model);
+        tn_step *path = malloc(length * sizeof(tn_step));
+        // Chaque lecture évalue toutes les variables x de chaque position
+        long literals = (long)tn_view_num_nodes(view) * (length + 1) * get_stack_size(length);
+        for (int r = 0; r < repetitions; r++)
+        {
+            long allocs_before = allocations();
+            unsigned long long bytes_before = Z3_get_estimated_alloc_size();
+            double start = tn_now();
+            tn_view_get_path_from_model_copy(ctx, model, view, 0, length, path);
+            s->seconds += tn_now() - start;
+            s->z3_bytes += Z3_get_estimated_alloc_size() - bytes_before;
+            if (allocs_before >= 0)
+                s->allocations += allocations() - allocs_before;
+            s->literals += literals;
+            s->calls++;
+        }
+        free(path);
+        Z3_model_dec_ref(ctx, model);
+    }
+    Z3_solver_dec_ref(ctx, solver);
+    Z3_del_context(ctx);
+    return sat;
+}
+
+static void print_sample(FILE *out, const fixed_network *network, int num_edges, int length, target t, const sample *s)
+{
+    fprintf(out, "%s,%d,%d,%d,%s,%d,%.0f,%ld,%.2f,%ld,", tn_bench_family_name(network->family), network->num_nodes,
+            num_edges, length, target_names[t], s->calls, 1e9 * s->seconds / s->calls, s->literals / s->calls,
+            s->literals > 0 ? 1e9 * s->seconds / s->literals : 0.0, s->clauses / s->calls);
+    if (allocations() >= 0 && s->clauses > 0)
+        fprintf(out, "%.2f", (double)s->allocations / s->clauses);
+    fprintf(out, ",%.1f\n", s->clauses > 0 ? (double)s->z3_bytes / s->clauses : 0.0);
+}
+
+void tn_microbench_run(int repetitions, FILE *out)
+{
+    if (repetitions < 1)
+        repetitions = 1;
+    fprintf(out, "network,nodes,edges,length,builder,calls,ns_per_call,literals,ns_per_literal,clauses,"
+                 "allocs_per_clause,z3_bytes_per_clause\n");
+
+    for (int n = 0; n < NUM_NETWORKS; n++)
+    {
+        tn_graph graph = tn_bench_generate(networks[n].family, networks[n].num_nodes, networks[n].degree, 1);
+        tn_view view = tn_view_from_graph(graph);
+        for (int l = 0; l < NUM_LENGTHS; l++)
+        {
+            for (int t = 0; t < target_get_path; t++)
+            {
+                sample s;
+                memset(&s, 0, sizeof(s));
+                // Un premier appel non mesuré pour les caches et les tables de symboles de Z3
+                sample warmup;
+                memset(&warmup, 0, sizeof(warmup));
+                measure_builder(view, (target)t, lengths[l], &warmup);
+                for (int r = 0; r < repetitions; r++)
+                    measure_builder(view, (target)t, lengths[l], &s);
+                print_sample(out, &networks[n], tn_graph_num_edges(graph), lengths[l], (target)t, &s);
+            }
+            sample s;
+            memset(&s, 0, sizeof(s));
+            if (measure_get_path(view, lengths[l], repetitions, &s))
+                print_sample(out, &networks[n], tn_graph_num_edges(graph), lengths[l], target_get_path, &s);
+            fflush(out);
+        }
+        tn_view_delete(view);
+        tn_graph_delete(graph);
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef TUNNEL_MICROBENCH_H
+#define TUNNEL_MICROBENCH_H
+
+#include <stdio.h>
+
+/**
+ * @file TunnelMicrobench.h
+ * @brief Micro-benchmarks of the encoder, without the solver.
+ *
+ * Each builder of the reduction (see tn_view_formula_part_copy), tn_path_variable and
+ * tn_view_get_path_from_model_copy is timed alone on fixed generated networks and lengths, in a fresh context
+ * for every repetition so that Z3's hash-consing of an earlier build does not hide the cost. Each line of the
+ * report gives the time per call and per generated literal, and the allocations per clause.
+ *
+ * The allocations are counted by wrapping malloc, calloc and realloc when this file is compiled with
+ * TN_COUNT_ALLOCATIONS (glibc only); otherwise the column is left empty. The bytes reported by
+ * Z3_get_estimated_alloc_size are always given.
+ */
+
+/**
+ * @brief Runs the micro-benchmarks and prints one CSV line per (network, length, builder).
+ *
+ * @param repetitions The number of timed calls of each builder (at least 1).
+ * @param out The output stream.
+ */
+void tn_microbench_run(int repetitions, FILE *out);
+
+#endif
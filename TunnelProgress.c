@@ -0,0 +1,239 @@
+#include "TunnelProgress.h"
+#include "TunnelCommon.h"
+#include "TunnelMemory.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+// Statistiques de Z3 suivies, sous leur nom du solveur SMT ou du solveur SAT selon la tactique choisie par Z3
+typedef enum
+{
+    solver_conflicts,
+    solver_decisions,
+    solver_restarts,
+    solver_clauses,
+    NUM_SOLVER_STATS
+} solver_stat;
+
+static const char *stat_names[NUM_SOLVER_STATS] = {"conflicts", "decisions", "restarts", "clauses"};
+static const char *stat_keys[][2] = {
+    {"conflicts", "sat conflicts"},
+    {"decisions", "sat decisions"},
+    {"restarts", "sat restarts"},
+    {"mk clause", "sat mk clause"}, // clauses créées, apprises comprises ("sat mk clause 2ary" et "nary")
+};
+
+static atomic_bool enabled;
+static const char *_Atomic phase = "idle";
+static atomic_int length;
+static atomic_int best_length = -1;
+static atomic_long phase_start_ms;
+static atomic_ulong num_checks;
+static atomic_ulong totals[NUM_SOLVER_STATS];
+static _Thread_local unsigned long check_start[NUM_SOLVER_STATS];
+static _Thread_local bool check_counted; // check_start a été lu pour l'appel en cours
+
+static pthread_t monitor;
+static pthread_mutex_t monitor_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t monitor_wakeup = PTHREAD_COND_INITIALIZER;
+static bool stopping;
+static char *metrics_file;
+static unsigned interval;
+static double origin;
+
+#define MB (1024.0 * 1024.0)
+
+static long now_ms(void)
+{
+    return (long)((tn_now() - origin) * 1000);
+}
+
+static void read_solver(Z3_context ctx, Z3_solver solver, unsigned long values[NUM_SOLVER_STATS])
+{
+    memset(values, 0, NUM_SOLVER_STATS * sizeof(unsigned long));
+    Z3_stats stats = Z3_solver_get_statistics(ctx, solver);
+    Z3_stats_inc_ref(ctx, stats);
+    for (unsigned i = 0; i < Z3_stats_size(ctx, stats); i++)
+    {
+        if (!Z3_stats_is_uint(ctx, stats, i))
+            continue;
+        const char *key = Z3_stats_get_key(ctx, stats, i);
+        for (int s = 0; s < NUM_SOLVER_STATS; s++)
+            if (strcmp(key, stat_keys[s][0]) == 0 || strncmp(key, stat_keys[s][1], strlen(stat_keys[s][1])) == 0)
+                values[s] += Z3_stats_get_uint_value(ctx, stats, i);
+    }
+    Z3_stats_dec_ref(ctx, stats);
+}
+
+void tn_progress_phase(const char *name, int current_length)
+{
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed))
+        return;
+    atomic_store(&phase, name);
+    atomic_store(&length, current_length);
+    atomic_store(&phase_start_ms, now_ms());
+}
+
+void tn_progress_best_length(int found_length)
+{
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed))
+        return;
+    atomic_store(&best_length, found_length);
+}
+
+// Les statistiques sont lues une fois avant et une fois après l'appel, pour le moniteur comme pour l'appelant
+void tn_progress_check_begin(Z3_context ctx, Z3_solver solver, int current_length, bool count)
+{
+    bool monitored = atomic_load_explicit(&enabled, memory_order_relaxed);
+    check_counted = monitored || count;
+    if (check_counted)
+        read_solver(ctx, solver, check_start);
+    if (monitored)
+        tn_progress_phase("check", current_length);
+}
+
+void tn_progress_check_end(Z3_context ctx, Z3_solver solver, tn_check_stats *delta)
+{
+    unsigned long values[NUM_SOLVER_STATS] = {0};
+    if (check_counted)
+    {
+        read_solver(ctx, solver, values);
+        for (int s = 0; s < NUM_SOLVER_STATS; s++)
+            values[s] -= check_start[s];
+        check_counted = false;
+    }
+    if (delta != NULL)
+        *delta = (tn_check_stats){values[solver_conflicts], values[solver_decisions], values[solver_restarts],
+                                  values[solver_clauses]};
+
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed))
+        return;
+    for (int s = 0; s < NUM_SOLVER_STATS; s++)
+        atomic_fetch_add(&totals[s], values[s]);
+    atomic_fetch_add(&num_checks, 1);
+    tn_progress_phase("idle", atomic_load(&length));
+}
+
+// Un instantané : ligne sur stderr, ou fichier de métriques réécrit d'un coup (écrit à côté puis renommé)
+static void write_snapshot(unsigned long previous_conflicts, double seconds_since_previous)
+{
+    double elapsed = tn_now() - origin;
+    double phase_seconds = (now_ms() - atomic_load(&phase_start_ms)) / 1000.0;
+    const char *current_phase = atomic_load(&phase);
+    int current_length = atomic_load(&length);
+    int best = atomic_load(&best_length);
+    unsigned long values[NUM_SOLVER_STATS];
+    for (int s = 0; s < NUM_SOLVER_STATS; s++)
+        values[s] = atomic_load(&totals[s]);
+    double rate = seconds_since_previous > 0 ? (values[solver_conflicts] - previous_conflicts) / seconds_since_previous : 0;
+    tn_memory_usage usage;
+    tn_memory_read(&usage);
+
+    if (metrics_file == NULL)
+    {
+        fprintf(stderr, "[progress] %8.1f s  %-8s %6.1f s  length %3d  best %3d  checks %lu  conflicts %lu (%.0f/s)  "
+                        "decisions %lu  restarts %lu  clauses %lu  Z3 %.1f MB  RSS %.1f MB\n",
+                elapsed, current_phase, phase_seconds, current_length, best, atomic_load(&num_checks),
+                values[solver_conflicts], rate, values[solver_decisions], values[solver_restarts],
+                values[solver_clauses], usage.z3_bytes / MB, usage.rss_bytes / MB);
+        return;
+    }
+
+    size_t size = strlen(metrics_file) + 5;
+    char *temporary = malloc(size);
+    snprintf(temporary, size, "%s.tmp", metrics_file);
+    FILE *out = fopen(temporary, "w");
+    if (out == NULL)
+    {
+        perror(temporary);
+        free(temporary);
+        return;
+    }
+    fprintf(out, "tunnel_elapsed_seconds %.3f\n", elapsed);
+    fprintf(out, "tunnel_phase{phase=\"%s\"} 1\n", current_phase);
+    fprintf(out, "tunnel_phase_seconds %.3f\n", phase_seconds);
+    fprintf(out, "tunnel_length %d\n", current_length);
+    fprintf(out, "tunnel_best_length %d\n", best);
+    fprintf(out, "tunnel_checks %lu\n", atomic_load(&num_checks));
+    for (int s = 0; s < NUM_SOLVER_STATS; s++)
+        fprintf(out, "tunnel_%s %lu\n", stat_names[s], values[s]);
+    fprintf(out, "tunnel_conflicts_per_second %.1f\n", rate);
+    fprintf(out, "tunnel_z3_bytes %zu\n", usage.z3_bytes);
+    fprintf(out, "tunnel_rss_bytes %zu\n", usage.rss_bytes);
+    fclose(out);
+    if (rename(temporary, metrics_file) != 0)
+        perror(metrics_file);
+    free(temporary);
+}
+
+static void *monitor_main(void *arg)
+{
+    (void)arg;
+    unsigned long previous_conflicts = 0;
+    double previous = tn_now();
+    pthread_mutex_lock(&monitor_lock);
+    while (!stopping)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += interval / 1000;
+        deadline.tv_nsec += (long)(interval % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        while (!stopping && pthread_cond_timedwait(&monitor_wakeup, &monitor_lock, &deadline) == 0)
+            ;
+        // Dernier instantané aussi à l'arrêt
+        double current = tn_now();
+        write_snapshot(previous_conflicts, current - previous);
+        previous_conflicts = atomic_load(&totals[solver_conflicts]);
+        previous = current;
+    }
+    pthread_mutex_unlock(&monitor_lock);
+    return NULL;
+}
+
+bool tn_progress_start(const char *filename, unsigned interval_ms)
+{
+    tn_progress_stop();
+    origin = tn_now();
+    stopping = false;
+    metrics_file = filename == NULL ? NULL : strdup(filename);
+    interval = interval_ms > 0 ? interval_ms : 1;
+    atomic_store(&phase, "idle");
+    atomic_store(&phase_start_ms, 0);
+    atomic_store(&length, 0);
+    atomic_store(&best_length, -1);
+    atomic_store(&num_checks, 0);
+    for (int s = 0; s < NUM_SOLVER_STATS; s++)
+        atomic_store(&totals[s], 0);
+    atomic_store(&enabled, true);
+    if (pthread_create(&monitor, NULL, monitor_main, NULL) != 0)
+    {
+        fprintf(stderr, "Cannot start the progress monitor\n");
+        atomic_store(&enabled, false);
+        free(metrics_file);
+        metrics_file = NULL;
+        return false;
+    }
+    return true;
+}
+
+void tn_progress_stop(void)
+{
+    if (!atomic_load(&enabled))
+        return;
+    pthread_mutex_lock(&monitor_lock);
+    stopping = true;
+    pthread_cond_signal(&monitor_wakeup);
+    pthread_mutex_unlock(&monitor_lock);
+    pthread_join(monitor, NULL);
+    atomic_store(&enabled, false);
+    free(metrics_file);
+    metrics_file = NULL;
+}
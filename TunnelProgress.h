@@ -0,0 +1,88 @@
+#ifndef TUNNEL_PROGRESS_H
+#define TUNNEL_PROGRESS_H
+
+#include <stdbool.h>
+#include <z3.h>
+
+/**
+ * @file TunnelProgress.h
+ * @brief Periodic progress snapshots of long solves, written by a monitoring thread (-progress).
+ *
+ * The solve pipeline records its phase, the length tried and the best length found, and folds the statistics
+ * of the solver (conflicts, decisions, restarts, clauses) in after each check. Every interval, the monitoring
+ * thread writes a snapshot of them with the memory in use, either as one line on stderr or by rewriting a
+ * metrics file with one "name value" line per metric.
+ *
+ * Z3 gives no safe access to the statistics of a check still running: during one long check they stand still,
+ * while the time in the phase and the memory of Z3 keep moving. A hung query shows neither.
+ *
+ * While no monitor runs, the recording functions only test a flag.
+ */
+
+/**
+ * @brief Starts the monitoring thread. A monitor already running is stopped first.
+ *
+ * @param metrics_file The metrics file, rewritten at each snapshot, or NULL for lines on stderr.
+ * @param interval_ms The time between two snapshots, in milliseconds.
+ * @return true on success (a message is printed on stderr otherwise).
+ */
+bool tn_progress_start(const char *metrics_file, unsigned interval_ms);
+
+/**
+ * @brief Writes a last snapshot and stops the monitoring thread.
+ */
+void tn_progress_stop(void);
+
+/**
+ * @brief Records that the pipeline enters a phase ("encode", "check", "search", "idle", ...) for a length.
+ *
+ * @param phase The name of the phase, a string that outlives the monitor.
+ * @param length The length tried.
+ */
+void tn_progress_phase(const char *phase, int length);
+
+/**
+ * @brief Records the length of a path found, the best one of a sweep.
+ *
+ * @param length The length of the path.
+ */
+void tn_progress_best_length(int length);
+
+/**
+ * @brief The statistics of one check.
+ */
+typedef struct
+{
+    unsigned long conflicts;
+    unsigned long decisions;
+    unsigned long restarts;
+    unsigned long clauses; ///< Clauses created, learned ones included.
+} tn_check_stats;
+
+/**
+ * @brief Enters the "check" phase before a call to a Z3_solver_check function on @p solver.
+ *
+ * The statistics of the solver are read if the monitor runs or if @p count is true, once here and once in
+ * tn_progress_check_end.
+ *
+ * @param ctx The context of the solver.
+ * @param solver The solver.
+ * @param length The length tried.
+ * @param count Whether the caller needs the statistics of the check from tn_progress_check_end, even without
+ * monitor (for a conflict budget).
+ */
+void tn_progress_check_begin(Z3_context ctx, Z3_solver solver, int length, bool count);
+
+/**
+ * @brief Folds the statistics of the check that just returned in, and leaves the "check" phase.
+ *
+ * Z3 sums the statistics over the checks of a solver: what moved since tn_progress_check_begin, on the same
+ * thread, is the check.
+ *
+ * @param ctx The context of the solver.
+ * @param solver The solver.
+ * @param delta The statistics of the check (zero if they were not read), or NULL.
+ */
+void tn_progress_check_end(Z3_context ctx, Z3_solver solver, tn_check_stats *delta);
+
+#endif
@@ -0,0 +1,430 @@
+#include "TunnelProtocols.h"
+#include "TunnelEncoding.h"
+#include "TunnelReduction.h"
+#include "Z3Tools.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+// Compte les appels à Z3 et les lectures de modèle (-stats) ; inclus en dernier pour ne pas toucher aux prototypes
+#define TN_STATS_WRAP_Z3
+#include "TunnelStats.h"
+#include "TunnelCommon.h"
+
+struct tn_protocol_network_s
+{
+    TunnelNetwork network;
+    int num_nodes;
+    int num_protocols;
+    char **names;
+    int base;
+    int num_bits; // variables par cellule de pile
+
+    tn_generic_action **actions; // actions[node][i]
+    int *num_actions;
+    int *max_actions;
+
+    bool legacy; // alphabet {4, 6} de TunnelNetwork.h : encodage spécialisé de tn_reduction
+};
+
+// Correspondance entre les actions de TunnelNetwork.h et les actions génériques (4 = protocole 0, 6 = protocole 1)
+static const struct
+{
+    action act;
+    tn_generic_action generic;
+} legacy_actions[] = {
+    {transmit_4, {tn_transmit, 0, 0}},
+    {transmit_6, {tn_transmit, 1, 1}},
+    {push_4_4, {tn_push, 0, 0}},
+    {push_4_6, {tn_push, 0, 1}},
+    {push_6_4, {tn_push, 1, 0}},
+    {push_6_6, {tn_push, 1, 1}},
+    {pop_4_4, {tn_pop, 0, 0}},
+    {pop_4_6, {tn_pop, 0, 1}},
+    {pop_6_4, {tn_pop, 1, 0}},
+    {pop_6_6, {tn_pop, 1, 1}},
+};
+
+#define NUM_LEGACY_ACTIONS ((int)(sizeof(legacy_actions) / sizeof(legacy_actions[0])))
+
+tn_protocol_network tn_protocol_network_create(const TunnelNetwork network, int num_protocols, const char **names, int base)
+{
+    tn_protocol_network pnet = malloc(sizeof(struct tn_protocol_network_s));
+    pnet->network = network;
+    pnet->num_nodes = tn_get_num_nodes(network);
+    pnet->num_protocols = num_protocols;
+    pnet->base = base;
+    pnet->legacy = false;
+
+    pnet->names = malloc(num_protocols * sizeof(char *));
+    for (int p = 0; p < num_protocols; p++)
+    {
+        pnet->names[p] = malloc(strlen(names[p]) + 1);
+        strcpy(pnet->names[p], names[p]);
+    }
+
+    // Codes 0..num_protocols : il faut num_bits bits avec 2^num_bits > num_protocols
+    pnet->num_bits = 1;
+    while ((1 << pnet->num_bits) <= num_protocols)
+        pnet->num_bits++;
+
+    pnet->actions = malloc(pnet->num_nodes * sizeof(tn_generic_action *));
+    pnet->num_actions = calloc(pnet->num_nodes, sizeof(int));
+    pnet->max_actions = calloc(pnet->num_nodes, sizeof(int));
+    for (int node = 0; node < pnet->num_nodes; node++)
+        pnet->actions[node] = NULL;
+    return pnet;
+}
+
+tn_protocol_network tn_protocol_network_from_network(const TunnelNetwork network)
+{
+    const char *names[2] = {"4", "6"};
+    tn_protocol_network pnet = tn_protocol_network_create(network, 2, names, 0);
+    for (int node = 0; node < pnet->num_nodes; node++)
+        for (int a = 0; a < NUM_LEGACY_ACTIONS; a++)
+            if (tn_node_has_action(network, node, legacy_actions[a].act))
+                tn_protocol_network_add_action(pnet, node, legacy_actions[a].generic);
+    pnet->legacy = true;
+    return pnet;
+}
+
+void tn_protocol_network_delete(tn_protocol_network pnet)
+{
+    for (int node = 0; node < pnet->num_nodes; node++)
+        free(pnet->actions[node]);
+    for (int p = 0; p < pnet->num_protocols; p++)
+        free(pnet->names[p]);
+    free(pnet->max_actions);
+    free(pnet->num_actions);
+    free(pnet->actions);
+    free(pnet->names);
+    free(pnet);
+}
+
+void tn_protocol_network_add_action(tn_protocol_network pnet, int node, tn_generic_action act)
+{
+    if (pnet->num_actions[node] == pnet->max_actions[node])
+    {
+        pnet->max_actions[node] = pnet->max_actions[node] == 0 ? 4 : 2 * pnet->max_actions[node];
+        pnet->actions[node] = realloc(pnet->actions[node], pnet->max_actions[node] * sizeof(tn_generic_action));
+    }
+    pnet->actions[node][pnet->num_actions[node]++] = act;
+
+    // Une action ajoutée à la main n'est plus forcément celle de TunnelNetwork.h
+    pnet->legacy = false;
+}
+
+const char *tn_protocol_name(const tn_protocol_network pnet, int protocol)
+{
+    return pnet->names[protocol];
+}
+
+// Variable "bit bit du code de la cellule height à la position pos"
+static Z3_ast cell_bit_variable(Z3_context ctx, int pos, int height, int bit)
+{
+    char name[60];
+    snprintf(name, 60, "cell bit %d at height %d on pos %d", bit, height, pos);
+    tn_stats_count(tn_counter_z3_calls, 2); // symbole et constante
+    return mk_bool_var(ctx, name);
+}
+
+// Chaque formule renvoyée par les fonctions suivantes est possédée par l'appelant (voir TunnelCommon.h)
+
+// La cellule height à la position pos contient le code code (0 = vide, p + 1 = protocole p)
+static Z3_ast cell_is(Z3_context ctx, const tn_protocol_network pnet, int pos, int height, int code)
+{
+    Z3_ast bits[32];
+    for (int b = 0; b < pnet->num_bits; b++)
+    {
+        Z3_ast var = cell_bit_variable(ctx, pos, height, b);
+        bits[b] = own(ctx, (code >> b) & 1 ? var : Z3_mk_not(ctx, var));
+    }
+    return and_release(ctx, pnet->num_bits, bits);
+}
+
+static Z3_ast cell_is_empty(Z3_context ctx, const tn_protocol_network pnet, int pos, int height)
+{
+    return cell_is(ctx, pnet, pos, height, 0);
+}
+
+// Les deux cellules ont le même contenu
+static Z3_ast same_cell(Z3_context ctx, const tn_protocol_network pnet, int pos, int pos2, int height)
+{
+    Z3_ast bits[32];
+    for (int b = 0; b < pnet->num_bits; b++)
+    {
+        Z3_ast vars[2] = {own(ctx, cell_bit_variable(ctx, pos, height, b)), own(ctx, cell_bit_variable(ctx, pos2, height, b))};
+        bits[b] = own(ctx, Z3_mk_eq(ctx, vars[0], vars[1]));
+        release(ctx, 2, vars);
+    }
+    return and_release(ctx, pnet->num_bits, bits);
+}
+
+// OR_{node} x_{node,pos,height}
+static Z3_ast height_at_position(Z3_context ctx, const tn_protocol_network pnet, int pos, int height)
+{
+    Z3_ast *vars = malloc(pnet->num_nodes * sizeof(Z3_ast));
+    for (int node = 0; node < pnet->num_nodes; node++)
+        vars[node] = own(ctx, tn_path_variable(ctx, node, pos, height));
+    Z3_ast result = or_release(ctx, pnet->num_nodes, vars);
+    free(vars);
+    return result;
+}
+
+// Le chemin est en node avec la pile [base] à la position pos
+static Z3_ast formula_endpoint(Z3_context ctx, const tn_protocol_network pnet, int node, int pos, int length)
+{
+    int stack_size = get_stack_size(length);
+    Z3_ast *constraints = malloc((pnet->num_nodes + 1) * stack_size * sizeof(Z3_ast));
+    int k = 0;
+
+    for (int n = 0; n < pnet->num_nodes; n++)
+    {
+        for (int h = 0; h < stack_size; h++)
+        {
+            Z3_ast var = tn_path_variable(ctx, n, pos, h);
+            constraints[k++] = own(ctx, n == node && h == 0 ? var : Z3_mk_not(ctx, var));
+        }
+    }
+    constraints[k++] = cell_is(ctx, pnet, pos, 0, pnet->base + 1);
+    for (int h = 1; h < stack_size; h++)
+        constraints[k++] = cell_is_empty(ctx, pnet, pos, h);
+
+    Z3_ast result = and_release(ctx, k, constraints);
+    free(constraints);
+    return result;
+}
+
+/**
+ * Pile bien formée : codes valides, cellules 0..h pleines et cellules au-dessus vides quand la hauteur est h,
+ * et cellules sous le sommet recopiées d'une position à la suivante.
+ */
+static Z3_ast formula_stacks(Z3_context ctx, const tn_protocol_network pnet, int length)
+{
+    int stack_size = get_stack_size(length);
+    int num_codes = 1 << pnet->num_bits;
+    Z3_ast *constraints = malloc(((length + 1) * stack_size * (num_codes + 1) + length * stack_size * stack_size) * sizeof(Z3_ast));
+    Z3_ast *cells = malloc(stack_size * sizeof(Z3_ast));
+    int k = 0;
+
+    for (int pos = 0; pos <= length; pos++)
+    {
+        // Les codes au-delà de num_protocols ne désignent aucun protocole
+        for (int h = 0; h < stack_size; h++)
+            for (int code = pnet->num_protocols + 1; code < num_codes; code++)
+            {
+                Z3_ast cell = cell_is(ctx, pnet, pos, h, code);
+                constraints[k++] = own(ctx, Z3_mk_not(ctx, cell));
+                Z3_dec_ref(ctx, cell);
+            }
+
+        for (int h = 0; h < stack_size; h++)
+        {
+            for (int c = 0; c < stack_size; c++)
+            {
+                Z3_ast empty = cell_is_empty(ctx, pnet, pos, c);
+                if (c > h)
+                    cells[c] = empty;
+                else
+                {
+                    cells[c] = own(ctx, Z3_mk_not(ctx, empty));
+                    Z3_dec_ref(ctx, empty);
+                }
+            }
+            Z3_ast height = height_at_position(ctx, pnet, pos, h);
+            Z3_ast stack = and_release(ctx, stack_size, cells);
+            constraints[k++] = own(ctx, Z3_mk_implies(ctx, height, stack));
+            Z3_dec_ref(ctx, height);
+            Z3_dec_ref(ctx, stack);
+        }
+    }
+
+    for (int pos = 0; pos < length; pos++)
+    {
+        for (int h = 0; h < stack_size; h++)
+        {
+            for (int h2 = 0; h2 < stack_size; h2++)
+            {
+                Z3_ast heights[2] = {height_at_position(ctx, pnet, pos, h), height_at_position(ctx, pnet, pos + 1, h2)};
+                Z3_ast both = and_release(ctx, 2, heights);
+                if (h2 > h + 1 || h2 < h - 1)
+                {
+                    constraints[k++] = own(ctx, Z3_mk_not(ctx, both));
+                    Z3_dec_ref(ctx, both);
+                    continue;
+                }
+                int top = h < h2 ? h : h2;
+                for (int c = 0; c <= top; c++)
+                    cells[c] = same_cell(ctx, pnet, pos, pos + 1, c);
+                Z3_ast frame = and_release(ctx, top + 1, cells);
+                constraints[k++] = own(ctx, Z3_mk_implies(ctx, both, frame));
+                Z3_dec_ref(ctx, both);
+                Z3_dec_ref(ctx, frame);
+            }
+        }
+    }
+
+    Z3_ast result = and_release(ctx, k, constraints);
+    free(cells);
+    free(constraints);
+    return result;
+}
+
+// Variation de hauteur, contenu du sommet avant (à pos) et après (à pos + 1) d'une action
+static void action_effect(tn_generic_action act, int *delta, int *before, int *after)
+{
+    switch (act.kind)
+    {
+    case tn_push:
+        *delta = 1;
+        *before = act.top;
+        *after = act.other;
+        break;
+    case tn_pop:
+        *delta = -1;
+        *before = act.other;
+        *after = act.top;
+        break;
+    default:
+        *delta = 0;
+        *before = act.top;
+        *after = act.top;
+        break;
+    }
+}
+
+// x_{u,pos,h} => OR_{action de u} (sommet avant ∧ sommet après ∧ OR_{u -> v} x_{v,pos+1,h+delta})
+static Z3_ast formula_transitions(Z3_context ctx, const tn_protocol_network pnet, int length)
+{
+    int num_nodes = pnet->num_nodes;
+    tn_view view = tn_view_from_network(pnet->network);
+    int stack_size = get_stack_size(length);
+    Z3_ast *constraints = malloc((length * num_nodes * stack_size + 1) * sizeof(Z3_ast));
+    Z3_ast *successors = malloc(num_nodes * sizeof(Z3_ast));
+    int k = 0;
+
+    for (int u = 0; u < num_nodes; u++)
+    {
+        Z3_ast *choices = malloc((pnet->num_actions[u] + 1) * sizeof(Z3_ast));
+        for (int pos = 0; pos < length; pos++)
+        {
+            for (int h = 0; h < stack_size; h++)
+            {
+                int num_choices = 0;
+                for (int a = 0; a < pnet->num_actions[u]; a++)
+                {
+                    int delta, before, after;
+                    action_effect(pnet->actions[u][a], &delta, &before, &after);
+                    int h2 = h + delta;
+                    if (h2 < 0 || h2 >= stack_size)
+                        continue;
+
+                    int num_successors;
+                    const int *targets = tn_view_successors(view, u, &num_successors);
+                    if (num_successors == 0)
+                        continue;
+                    for (int i = 0; i < num_successors; i++)
+                        successors[i] = own(ctx, tn_path_variable(ctx, targets[i], pos + 1, h2));
+
+                    Z3_ast choice[3] = {cell_is(ctx, pnet, pos, h, before + 1), cell_is(ctx, pnet, pos + 1, h2, after + 1),
+                                        or_release(ctx, num_successors, successors)};
+                    choices[num_choices++] = and_release(ctx, 3, choice);
+                }
+
+                Z3_ast x = own(ctx, tn_path_variable(ctx, u, pos, h));
+                if (num_choices == 0)
+                    constraints[k++] = own(ctx, Z3_mk_not(ctx, x));
+                else
+                {
+                    Z3_ast some_choice = or_release(ctx, num_choices, choices);
+                    constraints[k++] = own(ctx, Z3_mk_implies(ctx, x, some_choice));
+                    Z3_dec_ref(ctx, some_choice);
+                }
+                Z3_dec_ref(ctx, x);
+            }
+        }
+        free(choices);
+    }
+
+    Z3_ast result = and_release(ctx, k, constraints);
+    free(successors);
+    free(constraints);
+    tn_view_delete(view);
+    return result;
+}
+
+Z3_ast tn_protocol_reduction(Z3_context ctx, const tn_protocol_network pnet, int length)
+{
+    // Chemin rapide : l'encodage spécialisé à une variable par protocole
+    if (pnet->legacy)
+        return tn_reduction(ctx, pnet->network, length);
+
+    // Structure du chemin arrêtée par la limite de mémoire : pas d'encodage
+    Z3_ast structure = tn_path_structure_copy(ctx, pnet->network, 0, length);
+    if (structure == NULL)
+        return NULL;
+    Z3_ast parts[5];
+    int k = 0;
+    parts[k++] = formula_endpoint(ctx, pnet, tn_get_initial(pnet->network), 0, length);
+    parts[k++] = formula_endpoint(ctx, pnet, tn_get_final(pnet->network), length, length);
+    parts[k++] = structure;
+    parts[k++] = formula_stacks(ctx, pnet, length);
+    parts[k++] = formula_transitions(ctx, pnet, length);
+    return and_release(ctx, k, parts);
+}
+
+// Code de la cellule height à la position pos dans le modèle
+static int cell_code(Z3_context ctx, Z3_model model, int num_bits, int pos, int height)
+{
+    int code = 0;
+    for (int b = 0; b < num_bits; b++)
+        if (value_of_var_in_model(ctx, model, cell_bit_variable(ctx, pos, height, b)))
+            code |= 1 << b;
+    return code;
+}
+
+void tn_protocol_get_path_from_model(Z3_context ctx, Z3_model model, const tn_protocol_network pnet, int length, tn_generic_step *path)
+{
+    if (pnet->legacy)
+    {
+        tn_step *steps = malloc(length * sizeof(tn_step));
+        tn_get_path_from_model(ctx, model, pnet->network, length, steps);
+        for (int pos = 0; pos < length; pos++)
+        {
+            path[pos].source = steps[pos].source;
+            path[pos].target = steps[pos].target;
+            for (int a = 0; a < NUM_LEGACY_ACTIONS; a++)
+                if (legacy_actions[a].act == steps[pos].action)
+                    path[pos].action = legacy_actions[a].generic;
+        }
+        free(steps);
+        return;
+    }
+
+    int stack_size = get_stack_size(length);
+    int *nodes = malloc((length + 1) * sizeof(int));
+    int *heights = malloc((length + 1) * sizeof(int));
+    for (int pos = 0; pos <= length; pos++)
+        for (int n = 0; n < pnet->num_nodes; n++)
+            for (int h = 0; h < stack_size; h++)
+                if (value_of_var_in_model(ctx, model, tn_path_variable(ctx, n, pos, h)))
+                {
+                    nodes[pos] = n;
+                    heights[pos] = h;
+                }
+
+    for (int pos = 0; pos < length; pos++)
+    {
+        int before = cell_code(ctx, model, pnet->num_bits, pos, heights[pos]) - 1;
+        int after = cell_code(ctx, model, pnet->num_bits, pos + 1, heights[pos + 1]) - 1;
+        tn_generic_action act = {tn_transmit, before, before};
+        if (heights[pos + 1] == heights[pos] + 1)
+            act = (tn_generic_action){tn_push, before, after};
+        else if (heights[pos + 1] == heights[pos] - 1)
+            act = (tn_generic_action){tn_pop, after, before};
+        path[pos] = (tn_generic_step){act, nodes[pos], nodes[pos + 1]};
+    }
+
+    free(heights);
+    free(nodes);
+}
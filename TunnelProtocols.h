@@ -0,0 +1,118 @@
+#ifndef TUNNEL_PROTOCOLS_H
+#define TUNNEL_PROTOCOLS_H
+
+#include "TunnelNetwork.h"
+#include <stdbool.h>
+#include <z3.h>
+
+/**
+ * @file TunnelProtocols.h
+ * @brief Tunnel reduction for an arbitrary protocol alphabet (IPv4, IPv6, MPLS, GRE, ...).
+ *
+ * The nodes, edges and endpoints come from a TunnelNetwork, the alphabet and the actions of the nodes are
+ * declared separately. Each stack cell is encoded in binary: ceil(log2(num_protocols + 1)) variables per cell,
+ * the code 0 meaning an empty cell and the code p + 1 the protocol p.
+ *
+ * The alphabet {4, 6} with the actions of TunnelNetwork.h keeps the specialized encoding of tn_reduction (one
+ * variable per protocol and per cell), so the existing workload does not pay for the generality.
+ *
+ * Both encodings follow the reference counting of TunnelEncoding.h: they can be built in a context created
+ * with Z3_mk_context_rc, and the formula returned carries one reference owned by the caller.
+ */
+
+typedef enum
+{
+    tn_transmit, // top -> top
+    tn_push,     // top is @p top, @p other is pushed above it
+    tn_pop       // @p other is popped, @p top is the new top
+} tn_action_kind;
+
+/**
+ * @brief An action on an arbitrary alphabet. tn_push with top 4 and other 6 is push_4_6, tn_pop with top 4 and
+ * other 6 is pop_4_6.
+ */
+typedef struct
+{
+    tn_action_kind kind;
+    int top;
+    int other;
+} tn_generic_action;
+
+/**
+ * @brief A step of a path: the action performed by @p source before sending to @p target.
+ */
+typedef struct
+{
+    tn_generic_action action;
+    int source;
+    int target;
+} tn_generic_step;
+
+typedef struct tn_protocol_network_s *tn_protocol_network;
+
+/**
+ * @brief Creates a network with the nodes and edges of @p network and no action.
+ *
+ * @param network A TunnelNetwork.
+ * @param num_protocols The size of the alphabet.
+ * @param names The names of the protocols (copied).
+ * @param base The protocol at the bottom of the stack at both ends of a path.
+ * @return tn_protocol_network
+ */
+tn_protocol_network tn_protocol_network_create(const TunnelNetwork network, int num_protocols, const char **names, int base);
+
+/**
+ * @brief The alphabet {4, 6} (protocols 0 and 1, base 4) with the actions of the nodes of @p network.
+ *
+ * @param network A TunnelNetwork.
+ * @return tn_protocol_network
+ */
+tn_protocol_network tn_protocol_network_from_network(const TunnelNetwork network);
+
+/**
+ * @brief Frees the network (not the underlying TunnelNetwork).
+ *
+ * @param pnet A network.
+ */
+void tn_protocol_network_delete(tn_protocol_network pnet);
+
+/**
+ * @brief Gives an action to a node.
+ *
+ * @param pnet A network.
+ * @param node A node.
+ * @param act The action.
+ */
+void tn_protocol_network_add_action(tn_protocol_network pnet, int node, tn_generic_action act);
+
+/**
+ * @brief Name of a protocol.
+ *
+ * @param pnet A network.
+ * @param protocol A protocol.
+ * @return const char*
+ */
+const char *tn_protocol_name(const tn_protocol_network pnet, int protocol);
+
+/**
+ * @brief Formula satisfiable iff there is a valid path of length @p length.
+ *
+ * @param ctx The solver context.
+ * @param pnet A network.
+ * @param length The length of the sought path.
+ * @return Z3_ast The formula, or NULL if the memory limit stopped the encoding.
+ */
+Z3_ast tn_protocol_reduction(Z3_context ctx, const tn_protocol_network pnet, int length);
+
+/**
+ * @brief Reads the path in a model of tn_protocol_reduction.
+ *
+ * @param ctx The solver context.
+ * @param model A variable assignment.
+ * @param pnet A network.
+ * @param length The length of the path.
+ * @param path An array of size at least @p length.
+ */
+void tn_protocol_get_path_from_model(Z3_context ctx, Z3_model model, const tn_protocol_network pnet, int length, tn_generic_step *path);
+
+#endif
@@ -1,7 +1,18 @@
 #include "TunnelReduction.h"
+#include "TunnelEncoding.h"
+#include "TunnelView.h"
 #include "Z3Tools.h"
 #include "stdio.h"
+#include "stdlib.h"
+#include "TunnelMemory.h"
 #include "TunnelNetwork.h"
+#include "TunnelTrace.h"
+#include <pthread.h>
+
+// Compte les appels à Z3 et les lectures de modèle (-stats) ; inclus en dernier pour ne pas toucher aux prototypes
+#define TN_STATS_WRAP_Z3
+#include "TunnelStats.h"
+#include "TunnelCommon.h"
 
 /**
  * @brief Creates the variable "x_{node,pos,stack_height}" of the reduction (described in the subject).
@@ -14,9 +25,7 @@
  */
 Z3_ast tn_path_variable(Z3_context ctx, int node, int pos, int stack_height)
 {
-    char name[60];
-    snprintf(name, 60, "node %d,pos %d, height %d", node, pos, stack_height);
-    return mk_bool_var(ctx, name);
+    return tn_path_variable_copy(ctx, 0, node, pos, stack_height);
 }
 
 /**
@@ -29,9 +38,7 @@ Z3_ast tn_path_variable(Z3_context ctx, int node, int pos, int stack_height)
  */
 Z3_ast tn_4_variable(Z3_context ctx, int pos, int height)
 {
-    char name[60];
-    snprintf(name, 60, "4 at height %d on pos %d", height, pos);
-    return mk_bool_var(ctx, name);
+    return tn_4_variable_copy(ctx, 0, pos, height);
 }
 
 /**
@@ -44,8 +51,73 @@ Z3_ast tn_4_variable(Z3_context ctx, int pos, int height)
  */
 Z3_ast tn_6_variable(Z3_context ctx, int pos, int height)
 {
-    char name[60];
-    snprintf(name, 60, "6 at height %d on pos %d", height, pos);
+    return tn_6_variable_copy(ctx, 0, pos, height);
+}
+
+/**
+ * @brief Same as tn_path_variable, for the copy number @p copy of the path.
+ *
+ * The copy 0 is the one of tn_reduction (same names), the other copies get a prefix so that several
+ * paths can live in the same solver.
+ *
+ * @param ctx The solver context.
+ * @param copy The copy of the path.
+ * @param node A node.
+ * @param pos The path position.
+ * @param stack_height The highest cell occupied of the stack at that position.
+ * @return Z3_ast
+ */
+Z3_ast tn_path_variable_copy(Z3_context ctx, int copy, int node, int pos, int stack_height)
+{
+    char name[80];
+    if (copy == 0)
+        snprintf(name, 80, "node %d,pos %d, height %d", node, pos, stack_height);
+    else
+        snprintf(name, 80, "[copy %d] node %d,pos %d, height %d", copy, node, pos, stack_height);
+    tn_stats_count(tn_counter_path_variables, 1);
+    tn_stats_count(tn_counter_z3_calls, 2); // symbole et constante
+    return mk_bool_var(ctx, name);
+}
+
+/**
+ * @brief Same as tn_4_variable, for the copy number @p copy of the path.
+ *
+ * @param ctx The solver context.
+ * @param copy The copy of the path.
+ * @param pos The path position.
+ * @param height The height of the cell described.
+ * @return Z3_ast
+ */
+Z3_ast tn_4_variable_copy(Z3_context ctx, int copy, int pos, int height)
+{
+    char name[80];
+    if (copy == 0)
+        snprintf(name, 80, "4 at height %d on pos %d", height, pos);
+    else
+        snprintf(name, 80, "[copy %d] 4 at height %d on pos %d", copy, height, pos);
+    tn_stats_count(tn_counter_4_variables, 1);
+    tn_stats_count(tn_counter_z3_calls, 2); // symbole et constante
+    return mk_bool_var(ctx, name);
+}
+
+/**
+ * @brief Same as tn_6_variable, for the copy number @p copy of the path.
+ *
+ * @param ctx The solver context.
+ * @param copy The copy of the path.
+ * @param pos The path position.
+ * @param height The height of the cell described.
+ * @return Z3_ast
+ */
+Z3_ast tn_6_variable_copy(Z3_context ctx, int copy, int pos, int height)
+{
+    char name[80];
+    if (copy == 0)
+        snprintf(name, 80, "6 at height %d on pos %d", height, pos);
+    else
+        snprintf(name, 80, "[copy %d] 6 at height %d on pos %d", copy, height, pos);
+    tn_stats_count(tn_counter_6_variables, 1);
+    tn_stats_count(tn_counter_z3_calls, 2); // symbole et constante
     return mk_bool_var(ctx, name);
 }
 
@@ -60,6 +132,35 @@ int get_stack_size(int length)
     return length / 2 + 1;
 }
 
+// Un encodage public s'arrête au-delà de la limite de mémoire (tn_memory_check) : il échoue alors fermé, la
+// formule incomplète est relâchée et l'encodage renvoie NULL. Dans un encodage public appelé par un autre, c'est
+// le plus externe qui décide ; les tranches d'un encodage parallèle remontent leur dépassement dans capped.
+static _Thread_local int encoding_depth;
+static _Thread_local bool encoding_capped;
+
+static void begin_encoding(void)
+{
+    if (encoding_depth++ > 0)
+        return;
+    tn_memory_clear_exceeded();
+    encoding_capped = false;
+}
+
+// Vrai si l'encodage qui se termine est le plus externe et qu'il a dépassé la limite
+static bool end_encoding_capped(void)
+{
+    encoding_capped = encoding_capped || tn_memory_exceeded();
+    return --encoding_depth == 0 && encoding_capped;
+}
+
+static Z3_ast end_encoding(Z3_context ctx, Z3_ast formula)
+{
+    if (!end_encoding_capped())
+        return formula;
+    Z3_dec_ref(ctx, formula);
+    return NULL;
+}
+
 /**
  * formula_initial_and_final_positions : Formule SAT pour les contraintes de positions initiale et finale
  *
@@ -76,154 +177,166 @@ int get_stack_size(int length)
  * └─────────────┘              └─────────────┘
  *
  * param ctx = Le contexte du solveur Z3 (utilisé pour créer les variables et formules)
- * param network = Le réseau de tunnels contenant les nœuds et leurs connexions
+ * param view = La vue du réseau de tunnels (nœuds, arêtes et actions, voir TunnelView.h)
+ * param copy = La copie du chemin (0 pour tn_reduction, voir tn_path_variable_copy)
+ * param s = Le nœud source du chemin (tn_get_initial pour tn_reduction)
+ * param d = Le nœud destination du chemin (tn_get_final pour tn_reduction)
  * param length = La longueur du chemin recherché (nombre de transitions entre nœuds)
+ * param initial = Si faux, les contraintes de la position 0 (PARTIE 1) sont omises
+ * param final = Si faux, les contraintes de la position length (PARTIE 2) sont omises
  * return = Une formule Z3 (conjonction de toutes les contraintes) qui sera satisfaite si et seulement si
  *         les conditions initiales et finales sont respectées
  */
 
 static Z3_ast formula_initial_and_final_positions(Z3_context ctx,
-                                                  const TunnelNetwork network,
-                                                  int length)
+                                                  const tn_view view,
+                                                  int copy,
+                                                  int s,
+                                                  int d,
+                                                  int length,
+                                                  bool initial,
+                                                  bool final)
 {
+    tn_trace_span span = tn_trace_begin("formula_initial_and_final_positions", "encode");
+
     // ===== RÉCUPÉRATION DES PARAMÈTRES DU RÉSEAU =====
 
     // Nombre total de nœuds dans le graphe (récupéré depuis TunnelNetwork.h)
-    int num_nodes = tn_get_num_nodes(network);
+    int num_nodes = tn_view_num_nodes(view);
 
     // Taille maximale de la pile : length/2 + 1 cellules
     // Exemple : pour un chemin de longueur 10, on a besoin d'au plus 6 cellules de pile
     int stack_size = get_stack_size(length);
 
-    // Identifiant du nœud source (point de départ du chemin)
-    int s = tn_get_initial(network);
-
-    // Identifiant du nœud destination (point d'arrivée du chemin)
-    int d = tn_get_final(network);
-
     // ===== INITIALISATION DU TABLEAU DE CONTRAINTES =====
 
-    // Tableau qui va contenir 20 cases pour stocker des contraintes booléennes (T or F).
-    // Dimensionné large pour accueillir toutes les contraintes nécessaires
-    Z3_ast constraints[20];
+    // Tableau qui va stocker les contraintes booléennes (T or F).
+    // Pour chacune des 2 positions : num_nodes * stack_size variables x + 2 * stack_size variables y
+    Z3_ast *constraints = malloc((size_t)2 * (num_nodes + 2) * stack_size * sizeof(Z3_ast));
 
     // Compteur k pour suivre le nombre de contraintes ajoutées dans le tableau
     int k = 0;
 
-    // ========================================================================
-    // PARTIE 1 : CONTRAINTES À LA POSITION INITIALE (pos = 0)
-    // ========================================================================
+    if (initial)
+    {
+        // ========================================================================
+        // PARTIE 1 : CONTRAINTES À LA POSITION INITIALE (pos = 0)
+        // ========================================================================
 
-    // -----------------------
-    // 1.A) Configuration du nœud initial
-    // -----------------------
+        // -----------------------
+        // 1.A) Configuration du nœud initial
+        // -----------------------
 
-    // CONTRAINTE : Le chemin démarre exactement au nœud source 's' avec hauteur de pile 0
-    // Variable booléenne : x_{s,0,0} = true
-    // Signification : À la position 0, on est au nœud s, avec la pile contenant 1 seul élément (hauteur = 0)
-    constraints[k++] = tn_path_variable(ctx, s, 0, 0);
+        // CONTRAINTE : Le chemin démarre exactement au nœud source 's' avec hauteur de pile 0
+        // Variable booléenne : x_{s,0,0} = true
+        // Signification : À la position 0, on est au nœud s, avec la pile contenant 1 seul élément (hauteur = 0)
+        constraints[k++] = own(ctx, tn_path_variable_copy(ctx, copy, s, 0, 0));
 
-    // CONTRAINTE : Aucune autre configuration (nœud, hauteur) n'est possible à la position 0
-    // Pour tous les couples (node, h) différents de (s, 0) : x_{node,0,h} = false
-    for (int node = 0; node < num_nodes; node++)
-    {
-        for (int h = 0; h < stack_size; h++)
+        // CONTRAINTE : Aucune autre configuration (nœud, hauteur) n'est possible à la position 0
+        // Pour tous les couples (node, h) différents de (s, 0) : x_{node,0,h} = false
+        for (int node = 0; node < num_nodes; node++)
         {
-            // On saute la configuration (s, 0) qui est déjà fixée à true
-            if (node == s && h == 0)
-                continue;
+            for (int h = 0; h < stack_size; h++)
+            {
+                // On saute la configuration (s, 0) qui est déjà fixée à true
+                if (node == s && h == 0)
+                    continue;
 
-            // Création de la variable x_{node,0,h}
-            Z3_ast var = tn_path_variable(ctx, node, 0, h);
+                // Création de la variable x_{node,0,h}
+                Z3_ast var = tn_path_variable_copy(ctx, copy, node, 0, h);
 
-            // Ajout de la contrainte : NOT(x_{node,0,h})
-            // Cela interdit d'être à ce nœud ou à cette hauteur de pile
-            Z3_ast not_var = Z3_mk_not(ctx, var);
-            constraints[k++] = not_var;
+                // Ajout de la contrainte : NOT(x_{node,0,h})
+                // Cela interdit d'être à ce nœud ou à cette hauteur de pile
+                Z3_ast not_var = Z3_mk_not(ctx, var);
+                constraints[k++] = own(ctx, not_var);
+            }
         }
-    }
 
-    // -----------------------
-    // 1.B) État initial de la pile : [4]
-    // -----------------------
+        // -----------------------
+        // 1.B) État initial de la pile : [4]
+        // -----------------------
 
-    // CONTRAINTE : À la position 0, la cellule de base (hauteur 0) contient la valeur 4
-    // Variable : y_{0,0,4} = true
-    // Signification : La pile commence avec un unique élément de valeur 4
-    constraints[k++] = tn_4_variable(ctx, 0, 0);
+        // CONTRAINTE : À la position 0, la cellule de base (hauteur 0) contient la valeur 4
+        // Variable : y_{0,0,4} = true
+        // Signification : La pile commence avec un unique élément de valeur 4
+        constraints[k++] = own(ctx, tn_4_variable_copy(ctx, copy, 0, 0));
 
-    // CONTRAINTE : Cette même cellule ne contient PAS la valeur 6
-    // Variable : y_{0,0,6} = false
-    // Cela garantit qu'une cellule contient soit 4, soit 6, mais pas les deux
-    constraints[k++] = Z3_mk_not(ctx, tn_6_variable(ctx, 0, 0));
+        // CONTRAINTE : Cette même cellule ne contient PAS la valeur 6
+        // Variable : y_{0,0,6} = false
+        // Cela garantit qu'une cellule contient soit 4, soit 6, mais pas les deux
+        constraints[k++] = own(ctx, Z3_mk_not(ctx, tn_6_variable_copy(ctx, copy, 0, 0)));
 
-    // CONTRAINTE : Toutes les cellules au-dessus de la hauteur 0 sont vides
-    // Pour h = 1, 2, ..., stack_size-1 : y_{0,h,4} = false ET y_{0,h,6} = false
-    // Cela signifie que la pile ne contient qu'un seul élément au départ
-    for (int h = 1; h < stack_size; h++)
-    {
-        // La cellule h ne contient pas de 4
-        constraints[k++] = Z3_mk_not(ctx, tn_4_variable(ctx, 0, h));
+        // CONTRAINTE : Toutes les cellules au-dessus de la hauteur 0 sont vides
+        // Pour h = 1, 2, ..., stack_size-1 : y_{0,h,4} = false ET y_{0,h,6} = false
+        // Cela signifie que la pile ne contient qu'un seul élément au départ
+        for (int h = 1; h < stack_size; h++)
+        {
+            // La cellule h ne contient pas de 4
+            constraints[k++] = own(ctx, Z3_mk_not(ctx, tn_4_variable_copy(ctx, copy, 0, h)));
 
-        // La cellule h ne contient pas de 6
-        constraints[k++] = Z3_mk_not(ctx, tn_6_variable(ctx, 0, h));
+            // La cellule h ne contient pas de 6
+            constraints[k++] = own(ctx, Z3_mk_not(ctx, tn_6_variable_copy(ctx, copy, 0, h)));
+        }
     }
 
-    // ========================================================================
-    // PARTIE 2 : CONTRAINTES À LA POSITION FINALE (pos = length)
-    // ========================================================================
+    if (final)
+    {
+        // ========================================================================
+        // PARTIE 2 : CONTRAINTES À LA POSITION FINALE (pos = length)
+        // ========================================================================
 
-    // -----------------------
-    // 2.A) Configuration du nœud final
-    // -----------------------
+        // -----------------------
+        // 2.A) Configuration du nœud final
+        // -----------------------
 
-    // CONTRAINTE : Le chemin se termine exactement au nœud destination 'd' avec hauteur de pile 0
-    // Variable : x_{d,length,0} = true
-    // Signification : À la position finale, on doit être au nœud d avec la pile revenue à 1 élément
-    constraints[k++] = tn_path_variable(ctx, d, length, 0);
+        // CONTRAINTE : Le chemin se termine exactement au nœud destination 'd' avec hauteur de pile 0
+        // Variable : x_{d,length,0} = true
+        // Signification : À la position finale, on doit être au nœud d avec la pile revenue à 1 élément
+        constraints[k++] = own(ctx, tn_path_variable_copy(ctx, copy, d, length, 0));
 
-    // CONTRAINTE : Aucune autre configuration (nœud, hauteur) n'est possible à la position finale
-    // Pour tous les couples (node, h) différents de (d, 0) : x_{node,length,h} = false
-    for (int node = 0; node < num_nodes; node++)
-    {
-        for (int h = 0; h < stack_size; h++)
+        // CONTRAINTE : Aucune autre configuration (nœud, hauteur) n'est possible à la position finale
+        // Pour tous les couples (node, h) différents de (d, 0) : x_{node,length,h} = false
+        for (int node = 0; node < num_nodes; node++)
         {
-            // On saute la configuration (d, 0) qui est déjà fixée à true
-            if (node == d && h == 0)
-                continue;
+            for (int h = 0; h < stack_size; h++)
+            {
+                // On saute la configuration (d, 0) qui est déjà fixée à true
+                if (node == d && h == 0)
+                    continue;
 
-            // Création de la variable x_{node,length,h}
-            Z3_ast var = tn_path_variable(ctx, node, length, h);
+                // Création de la variable x_{node,length,h}
+                Z3_ast var = tn_path_variable_copy(ctx, copy, node, length, h);
 
-            // Ajout de la contrainte : NOT(x_{node,length,h})
-            // On ne peut être à aucun autre nœud ni avoir une autre hauteur de pile
-            Z3_ast not_var = Z3_mk_not(ctx, var);
-            constraints[k++] = not_var;
+                // Ajout de la contrainte : NOT(x_{node,length,h})
+                // On ne peut être à aucun autre nœud ni avoir une autre hauteur de pile
+                Z3_ast not_var = Z3_mk_not(ctx, var);
+                constraints[k++] = own(ctx, not_var);
+            }
         }
-    }
 
-    // -----------------------
-    // 2.B) État final de la pile : [4] (identique à l'état initial)
-    // -----------------------
+        // -----------------------
+        // 2.B) État final de la pile : [4] (identique à l'état initial)
+        // -----------------------
 
-    // CONTRAINTE : À la position finale, la cellule de base contient la valeur 4
-    // Variable : y_{length,0,4} = true
-    // La pile doit être revenue exactement à son état initial
-    constraints[k++] = tn_4_variable(ctx, length, 0);
+        // CONTRAINTE : À la position finale, la cellule de base contient la valeur 4
+        // Variable : y_{length,0,4} = true
+        // La pile doit être revenue exactement à son état initial
+        constraints[k++] = own(ctx, tn_4_variable_copy(ctx, copy, length, 0));
 
-    // CONTRAINTE : Cette cellule ne contient PAS la valeur 6
-    // Variable : y_{length,0,6} = false
-    constraints[k++] = Z3_mk_not(ctx, tn_6_variable(ctx, length, 0));
+        // CONTRAINTE : Cette cellule ne contient PAS la valeur 6
+        // Variable : y_{length,0,6} = false
+        constraints[k++] = own(ctx, Z3_mk_not(ctx, tn_6_variable_copy(ctx, copy, length, 0)));
 
-    // CONTRAINTE : Toutes les cellules au-dessus sont vides (comme au départ)
-    // Pour h = 1, 2, ..., stack_size-1 : y_{length,h,4} = false ET y_{length,h,6} = false
-    for (int h = 1; h < stack_size; h++)
-    {
-        // La cellule h ne contient pas de 4
-        constraints[k++] = Z3_mk_not(ctx, tn_4_variable(ctx, length, h));
+        // CONTRAINTE : Toutes les cellules au-dessus sont vides (comme au départ)
+        // Pour h = 1, 2, ..., stack_size-1 : y_{length,h,4} = false ET y_{length,h,6} = false
+        for (int h = 1; h < stack_size; h++)
+        {
+            // La cellule h ne contient pas de 4
+            constraints[k++] = own(ctx, Z3_mk_not(ctx, tn_4_variable_copy(ctx, copy, length, h)));
 
-        // La cellule h ne contient pas de 6
-        constraints[k++] = Z3_mk_not(ctx, tn_6_variable(ctx, length, h));
+            // La cellule h ne contient pas de 6
+            constraints[k++] = own(ctx, Z3_mk_not(ctx, tn_6_variable_copy(ctx, copy, length, h)));
+        }
     }
 
     // ===== RETOUR DE LA FORMULE FINALE =====
@@ -231,44 +344,939 @@ static Z3_ast formula_initial_and_final_positions(Z3_context ctx,
     // Retourne la conjonction (AND logique) de toutes les contraintes accumulées
     // La formule est satisfaite si et seulement si TOUTES les contraintes sont vraies simultanément
     // Cela garantit que le chemin commence correctement en 's' et termine en 'd' avec la pile [4]
-    return Z3_mk_and(ctx, k, constraints);
+    Z3_ast result = and_release(ctx, k, constraints);
+    free(constraints);
+    tn_trace_end(span);
+    tn_memory_phase("formula_initial_and_final_positions");
+    return result;
+}
+
+// Exactement un couple (node, height) à la position pos
+static Z3_ast formula_unique_node_at_position(Z3_context ctx,
+                                              const tn_view view,
+                                              int copy,
+                                              int pos,
+                                              int length)
+{
+    int num_nodes = tn_view_num_nodes(view);
+    int stack_size = get_stack_size(length);
+
+    // Toutes les variables x de la position
+    Z3_ast *vars = malloc((size_t)num_nodes * stack_size * sizeof(Z3_ast));
+    int n = 0;
+    for (int node = 0; node < num_nodes; node++)
+        for (int h = 0; h < stack_size; h++)
+            vars[n++] = own(ctx, tn_path_variable_copy(ctx, copy, node, pos, h));
+
+    // Au moins un couple (node, height) et au plus un couple (node, height) à la position pos
+    Z3_ast constraints[2];
+    constraints[0] = own(ctx, Z3_mk_or(ctx, n, vars));
+    constraints[1] = own(ctx, Z3_mk_atmost(ctx, n, vars, 1));
+    release(ctx, n, vars);
+
+    free(vars);
+    return and_release(ctx, 2, constraints);
 }
 
-// Unicité : à chaque position, exactement un (node,height)
+/**
+ * formula_unique_node_per_position : Formule SAT pour l'unicité à chaque position
+ *
+ * Pour chaque position pos (de 0 à length), exactement un couple (node, height) est vrai :
+ * - au moins un : OR des x_{node,pos,height}
+ * - au plus un  : AtMost(1, {x_{node,pos,height}})
+ *
+ * param ctx = Le contexte du solveur Z3
+ * param view = La vue du réseau de tunnels
+ * param copy = La copie du chemin (0 pour tn_reduction)
+ * param length = La longueur du chemin recherché
+ * return = La conjonction des contraintes d'unicité de toutes les positions
+ */
 static Z3_ast formula_unique_node_per_position(Z3_context ctx,
-                                               const TunnelNetwork network,
-                                               int length);
+                                               const tn_view view,
+                                               int copy,
+                                               int length)
+{
+    tn_trace_span span = tn_trace_begin("formula_unique_node_per_position", "encode");
+    // 1 contrainte par position
+    Z3_ast *constraints = malloc((length + 1) * sizeof(Z3_ast));
+    int k = 0;
+
+    // Arrêt anticipé au-delà de la limite de mémoire (l'encodage public renvoie alors NULL)
+    for (int pos = 0; pos <= length && tn_memory_check(); pos++)
+        constraints[k++] = formula_unique_node_at_position(ctx, view, copy, pos, length);
+
+    Z3_ast result = and_release(ctx, k, constraints);
+    free(constraints);
+    tn_trace_end(span);
+    tn_memory_phase("formula_unique_node_per_position");
+    return result;
+}
+
+// AtMost(1, {x_{node,pos,height}}) pour un nœud, vars étant un tableau de travail de taille (length + 1) * stack_size
+static Z3_ast formula_simple_path_on_node(Z3_context ctx, int copy, int node, int length, Z3_ast *vars)
+{
+    int stack_size = get_stack_size(length);
+    int n = 0;
+    for (int pos = 0; pos <= length; pos++)
+        for (int h = 0; h < stack_size; h++)
+            vars[n++] = own(ctx, tn_path_variable_copy(ctx, copy, node, pos, h));
+    Z3_ast result = own(ctx, Z3_mk_atmost(ctx, n, vars, 1));
+    release(ctx, n, vars);
+    return result;
+}
 
-// Chemin simple : chaque node apparaît au plus une fois
+/**
+ * formula_simple_path : Formule SAT pour le chemin simple (pas de cycle)
+ *
+ * Chaque nœud apparaît au plus une fois dans tout le chemin, toutes positions et hauteurs confondues :
+ * AtMost(1, {x_{node,pos,height} | 0 <= pos <= length, 0 <= height < stack_size})
+ *
+ * param ctx = Le contexte du solveur Z3
+ * param view = La vue du réseau de tunnels
+ * param copy = La copie du chemin (0 pour tn_reduction)
+ * param length = La longueur du chemin recherché
+ * return = La conjonction des contraintes AtMost de tous les nœuds
+ */
 static Z3_ast formula_simple_path(Z3_context ctx,
-                                  const TunnelNetwork network,
-                                  int length);
+                                  const tn_view view,
+                                  int copy,
+                                  int length)
+{
+    tn_trace_span span = tn_trace_begin("formula_simple_path", "encode");
+    int num_nodes = tn_view_num_nodes(view);
+    int stack_size = get_stack_size(length);
+
+    // Toutes les variables x d'un même nœud
+    Z3_ast *vars = malloc((size_t)(length + 1) * stack_size * sizeof(Z3_ast));
+
+    // 1 contrainte par nœud
+    Z3_ast *constraints = malloc(num_nodes * sizeof(Z3_ast));
+    int k = 0;
+
+    for (int node = 0; node < num_nodes && tn_memory_check(); node++)
+        constraints[k++] = formula_simple_path_on_node(ctx, copy, node, length, vars);
+
+    Z3_ast result = and_release(ctx, k, constraints);
+    free(vars);
+    free(constraints);
+    tn_trace_end(span);
+    tn_memory_phase("formula_simple_path");
+    return result;
+}
+
+// Description d'une action sur la pile :
+// - delta = variation de la hauteur (0 pour T, +1 pour PUSH, -1 pour POP)
+// - before = protocole du sommet de la pile avant l'action (à la position pos)
+// - after = protocole du sommet de la pile après l'action (à la position pos + 1)
+// Exemple : push_4_6 = "4↑46" : sommet 4 avant, 6 empilé au-dessus
+//           pop_4_6 = "46↓4" : sommet 6 dépilé, 4 redevient le sommet
+typedef struct
+{
+    action act;
+    int delta;
+    int before;
+    int after;
+} stack_action;
+
+static const stack_action stack_actions[] = {
+    {transmit_4, 0, 4, 4},
+    {transmit_6, 0, 6, 6},
+    {push_4_4, 1, 4, 4},
+    {push_4_6, 1, 4, 6},
+    {push_6_4, 1, 6, 4},
+    {push_6_6, 1, 6, 6},
+    {pop_4_4, -1, 4, 4},
+    {pop_4_6, -1, 6, 4},
+    {pop_6_4, -1, 4, 6},
+    {pop_6_6, -1, 6, 6},
+};
+
+#define NUM_STACK_ACTIONS ((int)(sizeof(stack_actions) / sizeof(stack_actions[0])))
+
+// Variable y_{pos,height,proto} (proto = 4 ou 6)
+static Z3_ast protocol_variable(Z3_context ctx, int copy, int pos, int height, int proto)
+{
+    if (proto == 4)
+        return tn_4_variable_copy(ctx, copy, pos, height);
+    return tn_6_variable_copy(ctx, copy, pos, height);
+}
+
+// OR_{node} x_{node,pos,height} : la pile a la hauteur height à la position pos (formule possédée)
+static Z3_ast height_at_position(Z3_context ctx, const tn_view view, int copy, int pos, int height)
+{
+    int num_nodes = tn_view_num_nodes(view);
+    Z3_ast *vars = malloc(num_nodes * sizeof(Z3_ast));
+    for (int node = 0; node < num_nodes; node++)
+        vars[node] = own(ctx, tn_path_variable_copy(ctx, copy, node, pos, height));
+    Z3_ast result = or_release(ctx, num_nodes, vars);
+    free(vars);
+    return result;
+}
+
+// OR_{height} x_{node,pos,height} : le chemin passe par node à la position pos
+Z3_ast tn_node_at_position(Z3_context ctx, int copy, int node, int pos, int length)
+{
+    int stack_size = get_stack_size(length);
+    Z3_ast *vars = malloc(stack_size * sizeof(Z3_ast));
+    for (int h = 0; h < stack_size; h++)
+        vars[h] = own(ctx, tn_path_variable_copy(ctx, copy, node, pos, h));
+    Z3_ast result = or_release(ctx, stack_size, vars);
+    free(vars);
+    return result;
+}
+
+/**
+ * formula_well_formed_stack_at : La pile est bien formée à la position pos
+ *
+ * - une cellule ne contient jamais à la fois 4 et 6
+ * - si la hauteur est h à la position pos, les cellules 0..h sont remplies et les cellules au-dessus sont vides
+ */
+static Z3_ast formula_well_formed_stack_at(Z3_context ctx,
+                                           const tn_view view,
+                                           int copy,
+                                           int pos,
+                                           int length)
+{
+    int stack_size = get_stack_size(length);
+    Z3_ast *constraints = malloc(2 * stack_size * sizeof(Z3_ast));
+    Z3_ast *cells = malloc(stack_size * sizeof(Z3_ast));
+    int k = 0;
+
+    for (int c = 0; c < stack_size; c++)
+    {
+        Z3_ast both[2] = {own(ctx, tn_4_variable_copy(ctx, copy, pos, c)), own(ctx, tn_6_variable_copy(ctx, copy, pos, c))};
+        Z3_ast both_filled = and_release(ctx, 2, both);
+        constraints[k++] = own(ctx, Z3_mk_not(ctx, both_filled));
+        Z3_dec_ref(ctx, both_filled);
+    }
+
+    for (int h = 0; h < stack_size; h++)
+    {
+        for (int c = 0; c < stack_size; c++)
+        {
+            Z3_ast y[2] = {own(ctx, tn_4_variable_copy(ctx, copy, pos, c)), own(ctx, tn_6_variable_copy(ctx, copy, pos, c))};
+            Z3_ast filled = or_release(ctx, 2, y);
+            if (c <= h)
+                cells[c] = filled;
+            else
+            {
+                cells[c] = own(ctx, Z3_mk_not(ctx, filled));
+                Z3_dec_ref(ctx, filled);
+            }
+        }
+        Z3_ast height = height_at_position(ctx, view, copy, pos, h);
+        Z3_ast stack = and_release(ctx, stack_size, cells);
+        constraints[k++] = own(ctx, Z3_mk_implies(ctx, height, stack));
+        Z3_dec_ref(ctx, height);
+        Z3_dec_ref(ctx, stack);
+    }
+
+    Z3_ast result = and_release(ctx, k, constraints);
+    free(cells);
+    free(constraints);
+    return result;
+}
+
+/**
+ * formula_stack_frame : Les cellules sous le sommet ne changent pas entre pos et pos + 1
+ *
+ * Si la hauteur passe de h à h2 (|h - h2| <= 1), les cellules 0..min(h,h2) sont recopiées.
+ * Une hauteur qui varie de plus de 1 est interdite.
+ */
+static Z3_ast formula_stack_frame(Z3_context ctx,
+                                  const tn_view view,
+                                  int copy,
+                                  int pos,
+                                  int length)
+{
+    int stack_size = get_stack_size(length);
+    Z3_ast *constraints = malloc((size_t)stack_size * stack_size * sizeof(Z3_ast));
+    Z3_ast *cells = malloc(2 * stack_size * sizeof(Z3_ast));
+    int k = 0;
+
+    for (int h = 0; h < stack_size; h++)
+    {
+        for (int h2 = 0; h2 < stack_size; h2++)
+        {
+            Z3_ast heights[2] = {height_at_position(ctx, view, copy, pos, h),
+                                 height_at_position(ctx, view, copy, pos + 1, h2)};
+            Z3_ast both = and_release(ctx, 2, heights);
+
+            if (h2 > h + 1 || h2 < h - 1)
+            {
+                constraints[k++] = own(ctx, Z3_mk_not(ctx, both));
+                Z3_dec_ref(ctx, both);
+                continue;
+            }
+
+            int n = 0;
+            int top = h < h2 ? h : h2;
+            for (int c = 0; c <= top; c++)
+            {
+                Z3_ast y4 = own(ctx, tn_4_variable_copy(ctx, copy, pos, c));
+                cells[n++] = own(ctx, Z3_mk_eq(ctx, y4, tn_4_variable_copy(ctx, copy, pos + 1, c)));
+                Z3_ast y6 = own(ctx, tn_6_variable_copy(ctx, copy, pos, c));
+                cells[n++] = own(ctx, Z3_mk_eq(ctx, y6, tn_6_variable_copy(ctx, copy, pos + 1, c)));
+                Z3_dec_ref(ctx, y4);
+                Z3_dec_ref(ctx, y6);
+            }
+            Z3_ast frame = and_release(ctx, n, cells);
+            constraints[k++] = own(ctx, Z3_mk_implies(ctx, both, frame));
+            Z3_dec_ref(ctx, both);
+            Z3_dec_ref(ctx, frame);
+        }
+    }
+
+    Z3_ast result = and_release(ctx, k, constraints);
+    free(cells);
+    free(constraints);
+    return result;
+}
+
+/**
+ * formula_stack_evolution : Partie "pile" des transitions, indépendante du graphe
+ *
+ * La pile est bien formée à chaque position, et les cellules sous le sommet sont recopiées d'une position
+ * à la suivante.
+ */
+static Z3_ast formula_stack_evolution(Z3_context ctx,
+                                      const tn_view view,
+                                      int copy,
+                                      int length)
+{
+    tn_trace_span span = tn_trace_begin("formula_stack_evolution", "encode");
+    Z3_ast *constraints = malloc((2 * length + 1) * sizeof(Z3_ast));
+    int k = 0;
+
+    for (int pos = 0; pos <= length && tn_memory_check(); pos++)
+        constraints[k++] = formula_well_formed_stack_at(ctx, view, copy, pos, length);
+    for (int pos = 0; pos < length && tn_memory_check(); pos++)
+        constraints[k++] = formula_stack_frame(ctx, view, copy, pos, length);
+
+    Z3_ast result = and_release(ctx, k, constraints);
+    free(constraints);
+    tn_trace_end(span);
+    return result;
+}
+
+/**
+ * formula_transitions_from_node : Transitions valides depuis le nœud u (graphe + pile)
+ *
+ * Pour chaque position first_pos <= pos < last_pos, si le chemin est en (u, h) à la position pos, alors u effectue une de
+ * ses actions (T, PUSH, POP) compatible avec le sommet de la pile, et le chemin continue à la position pos + 1
+ * sur un successeur v de u (arête u -> v) avec la hauteur h + delta :
+ *
+ * x_{u,pos,h} => OR_{action de u} ( y_{pos,h,before} ∧ y_{pos+1,h+delta,after} ∧ OR_{u -> v} x_{v,pos+1,h+delta} )
+ *
+ * param successors = Les num_successors successeurs de u
+ * param actions = Les actions de u : le bit a correspond à stack_actions[a]
+ * param first_pos, last_pos = Les positions concernées (last_pos = length pour tout le chemin)
+ * param guarded = Si vrai, chaque arête u -> v n'est utilisable que si tn_edge_enable_variable(u, v) est vrai
+ */
+static Z3_ast formula_transitions_from_node(Z3_context ctx,
+                                            int copy,
+                                            int u,
+                                            int num_successors,
+                                            const int *successors,
+                                            unsigned actions,
+                                            int first_pos,
+                                            int last_pos,
+                                            int length,
+                                            bool guarded)
+{
+    int stack_size = get_stack_size(length);
+
+    // 1 contrainte par (pos, h)
+    Z3_ast *constraints = malloc(((size_t)(last_pos - first_pos) * stack_size + 1) * sizeof(Z3_ast));
+    Z3_ast *choices = malloc(NUM_STACK_ACTIONS * sizeof(Z3_ast));
+    Z3_ast *next = malloc((num_successors + 1) * sizeof(Z3_ast));
+    int k = 0;
+
+    for (int pos = first_pos; pos < last_pos; pos++)
+    {
+        for (int h = 0; h < stack_size; h++)
+        {
+            int num_choices = 0;
+            for (int a = 0; a < NUM_STACK_ACTIONS && num_successors > 0; a++)
+            {
+                const stack_action *sa = &stack_actions[a];
+                int h2 = h + sa->delta;
+                if (h2 < 0 || h2 >= stack_size || !(actions & (1u << a)))
+                    continue;
+
+                // Successeurs de u à la position pos + 1, avec la nouvelle hauteur
+                for (int i = 0; i < num_successors; i++)
+                {
+                    next[i] = own(ctx, tn_path_variable_copy(ctx, copy, successors[i], pos + 1, h2));
+                    if (guarded)
+                    {
+                        Z3_ast enabled_next[2] = {own(ctx, tn_edge_enable_variable(ctx, u, successors[i])), next[i]};
+                        next[i] = and_release(ctx, 2, enabled_next);
+                    }
+                }
 
-// Transitions valides : graphe + pile (T, PUSH, POP)
+                Z3_ast choice[3];
+                choice[0] = own(ctx, protocol_variable(ctx, copy, pos, h, sa->before));
+                choice[1] = own(ctx, protocol_variable(ctx, copy, pos + 1, h2, sa->after));
+                choice[2] = or_release(ctx, num_successors, next);
+                choices[num_choices++] = and_release(ctx, 3, choice);
+            }
+
+            Z3_ast x = own(ctx, tn_path_variable_copy(ctx, copy, u, pos, h));
+            if (num_choices == 0)
+                constraints[k++] = own(ctx, Z3_mk_not(ctx, x));
+            else
+            {
+                Z3_ast some_choice = or_release(ctx, num_choices, choices);
+                constraints[k++] = own(ctx, Z3_mk_implies(ctx, x, some_choice));
+                Z3_dec_ref(ctx, some_choice);
+            }
+            Z3_dec_ref(ctx, x);
+        }
+    }
+
+    Z3_ast result = and_release(ctx, k, constraints);
+    free(next);
+    free(choices);
+    free(constraints);
+    return result;
+}
+
+// Actions de u dans la vue : les bits de tn_graph_action_bit sont dans l'ordre de stack_actions
+static unsigned node_actions(const tn_view view, int u)
+{
+    return tn_view_node_actions(view, u);
+}
+
+// Transitions de tous les nœuds entre les positions pos et pos + 1
+static Z3_ast formula_transitions_at_position(Z3_context ctx,
+                                              const tn_view view,
+                                              int copy,
+                                              int pos,
+                                              int length)
+{
+    int num_nodes = tn_view_num_nodes(view);
+    Z3_ast *constraints = malloc(num_nodes * sizeof(Z3_ast));
+
+    for (int u = 0; u < num_nodes; u++)
+    {
+        int num_successors;
+        const int *successors = tn_view_successors(view, u, &num_successors);
+        constraints[u] = formula_transitions_from_node(ctx, copy, u, num_successors, successors, node_actions(view, u),
+                                                       pos, pos + 1, length, false);
+    }
+
+    Z3_ast result = and_release(ctx, num_nodes, constraints);
+    free(constraints);
+    return result;
+}
+
+/**
+ * formula_valid_transitions : Formule SAT pour les transitions valides (graphe + pile)
+ *
+ * Conjonction de formula_stack_evolution et de formula_transitions_from_node pour chaque nœud, avec les
+ * successeurs et les actions lus dans la vue du réseau.
+ *
+ * param ctx = Le contexte du solveur Z3
+ * param view = La vue du réseau de tunnels
+ * param copy = La copie du chemin (0 pour tn_reduction)
+ * param length = La longueur du chemin recherché
+ * param guarded = Si vrai, chaque arête u -> v n'est utilisable que si tn_edge_enable_variable(u, v) est vrai
+ * return = La conjonction des contraintes de transition et de pile
+ */
 static Z3_ast formula_valid_transitions(Z3_context ctx,
-                                        const TunnelNetwork network,
-                                        int length);
+                                        const tn_view view,
+                                        int copy,
+                                        int length,
+                                        bool guarded)
+{
+    tn_trace_span span = tn_trace_begin("formula_valid_transitions", "encode");
+    int num_nodes = tn_view_num_nodes(view);
 
-// Fonction qui permet de construire la reduction
+    // 1 formule par nœud, plus l'évolution de la pile
+    Z3_ast *constraints = malloc((num_nodes + 1) * sizeof(Z3_ast));
+    int k = 0;
 
-Z3_ast tn_reduction(Z3_context ctx, const TunnelNetwork network, int length)
+    constraints[k++] = formula_stack_evolution(ctx, view, copy, length);
+
+    for (int u = 0; u < num_nodes && tn_memory_check(); u++)
+    {
+        int num_successors;
+        const int *successors = tn_view_successors(view, u, &num_successors);
+        constraints[k++] = formula_transitions_from_node(ctx, copy, u, num_successors, successors, node_actions(view, u),
+                                                         0, length, length, guarded);
+    }
+
+    Z3_ast result = and_release(ctx, k, constraints);
+    free(constraints);
+    tn_trace_end(span);
+    tn_memory_phase("formula_valid_transitions");
+    return result;
+}
+
+// Variable "l'arête u -> v est disponible", partagée par toutes les copies et toutes les longueurs
+Z3_ast tn_edge_enable_variable(Z3_context ctx, int source, int target)
+{
+    char name[60];
+    snprintf(name, 60, "enable edge %d -> %d", source, target);
+    return mk_bool_var(ctx, name);
+}
+
+static Z3_ast reduction_copy(Z3_context ctx, const tn_view view, int copy, int source, int target, int length, bool guarded)
+{
+    Z3_ast parts[4];
+    int k = 0;
+
+    parts[k++] = formula_initial_and_final_positions(ctx, view, copy, source, target, length, true, true);
+    parts[k++] = formula_unique_node_per_position(ctx, view, copy, length);
+    parts[k++] = formula_simple_path(ctx, view, copy, length);
+    parts[k++] = formula_valid_transitions(ctx, view, copy, length, guarded);
+
+    return and_release(ctx, k, parts);
+}
+
+// Réduction complète pour une copie du chemin, de source à target
+Z3_ast tn_reduction_copy(Z3_context ctx, const TunnelNetwork network, int copy, int source, int target, int length)
+{
+    begin_encoding();
+    tn_view view = tn_view_from_network(network);
+    Z3_ast result = reduction_copy(ctx, view, copy, source, target, length, false);
+    tn_view_delete(view);
+    return end_encoding(ctx, result);
+}
+
+// Même réduction, chaque arête étant gardée par son littéral tn_edge_enable_variable
+Z3_ast tn_guarded_reduction_copy(Z3_context ctx, const TunnelNetwork network, int copy, int source, int target, int length)
+{
+    begin_encoding();
+    tn_view view = tn_view_from_network(network);
+    Z3_ast result = reduction_copy(ctx, view, copy, source, target, length, true);
+    tn_view_delete(view);
+    return end_encoding(ctx, result);
+}
+
+// Réduction complète sur une vue déjà construite (réseau ou graphe chargé), de son nœud initial à son nœud final
+Z3_ast tn_view_reduction_copy(Z3_context ctx, const tn_view view, int copy, int length)
+{
+    begin_encoding();
+    return end_encoding(ctx, reduction_copy(ctx, view, copy, tn_view_initial(view), tn_view_final(view), length, false));
+}
+
+// La réduction sans les positions initiale et finale, commune à tous les couples (source, target)
+Z3_ast tn_view_reduction_body_copy(Z3_context ctx, const tn_view view, int copy, int length)
+{
+    Z3_ast parts[3];
+    int k = 0;
+
+    begin_encoding();
+    parts[k++] = formula_unique_node_per_position(ctx, view, copy, length);
+    parts[k++] = formula_simple_path(ctx, view, copy, length);
+    parts[k++] = formula_valid_transitions(ctx, view, copy, length, false);
+
+    return end_encoding(ctx, and_release(ctx, k, parts));
+}
+
+// Les positions initiale et finale seules : avec tn_view_reduction_body_copy, c'est tn_reduction_copy
+Z3_ast tn_view_endpoints_copy(Z3_context ctx, const tn_view view, int copy, int source, int target, int length)
+{
+    return formula_initial_and_final_positions(ctx, view, copy, source, target, length, true, true);
+}
+
+// Un seul des constructeurs de tn_view_reduction_copy
+Z3_ast tn_view_formula_part_copy(Z3_context ctx, const tn_view view, tn_formula_part part, int copy, int length)
+{
+    Z3_ast result;
+    begin_encoding();
+    switch (part)
+    {
+    case tn_part_initial_and_final:
+        result = formula_initial_and_final_positions(ctx, view, copy, tn_view_initial(view), tn_view_final(view),
+                                                     length, true, true);
+        break;
+    case tn_part_unique_node:
+        result = formula_unique_node_per_position(ctx, view, copy, length);
+        break;
+    case tn_part_simple_path:
+        result = formula_simple_path(ctx, view, copy, length);
+        break;
+    default:
+        result = formula_valid_transitions(ctx, view, copy, length, false);
+        break;
+    }
+    return end_encoding(ctx, result);
+}
+
+// Une tranche de tn_view_reduction_body_copy, construite par un thread dans son propre contexte
+typedef struct
+{
+    Z3_context ctx;
+    tn_view view;
+    int copy;
+    int length;
+    int first_pos, last_pos;   // positions first_pos <= pos < last_pos
+    int first_node, last_node; // nœuds first_node <= node < last_node, pour le chemin simple
+    Z3_ast formula;
+    bool capped; // la tranche a atteint la limite de mémoire : elle est incomplète
+} body_slice;
+
+static void *build_body_slice(void *arg)
+{
+    body_slice *slice = arg;
+    tn_trace_name_thread("encoder slice");
+    tn_trace_span span = tn_trace_begin("build_body_slice", "encode");
+    Z3_context ctx = slice->ctx;
+    int length = slice->length;
+    int count = 2 * (slice->last_pos - slice->first_pos) + (slice->last_node - slice->first_node);
+    Z3_ast *constraints = malloc((count + 1) * sizeof(Z3_ast));
+    Z3_ast *vars = malloc((size_t)(length + 1) * get_stack_size(length) * sizeof(Z3_ast));
+    int k = 0;
+
+    tn_memory_clear_exceeded();
+    for (int pos = slice->first_pos; pos < slice->last_pos && tn_memory_check(); pos++)
+    {
+        constraints[k++] = formula_unique_node_at_position(ctx, slice->view, slice->copy, pos, length);
+        if (pos < length)
+            constraints[k++] = formula_transitions_at_position(ctx, slice->view, slice->copy, pos, length);
+    }
+    for (int node = slice->first_node; node < slice->last_node && tn_memory_check(); node++)
+        constraints[k++] = formula_simple_path_on_node(ctx, slice->copy, node, length, vars);
+
+    slice->formula = and_release(ctx, k, constraints);
+    slice->capped = tn_memory_exceeded();
+    free(vars);
+    free(constraints);
+    tn_trace_end(span);
+    return NULL;
+}
+
+// tn_view_reduction_body_copy construite par tranches de positions (et de nœuds) sur num_threads threads
+Z3_ast tn_view_parallel_reduction_body_copy(Z3_context ctx, const tn_view view, int copy, int length, int num_threads)
+{
+    if (num_threads <= 1)
+        return tn_view_reduction_body_copy(ctx, view, copy, length);
+
+    // L'évolution de la pile ne dépend pas du graphe : elle est construite dans ctx pendant que les threads
+    // construisent les transitions
+    begin_encoding();
+    int num_nodes = tn_view_num_nodes(view);
+    body_slice *slices = malloc(num_threads * sizeof(body_slice));
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    bool *threaded = malloc(num_threads * sizeof(bool));
+    for (int t = 0; t < num_threads; t++)
+    {
+        Z3_config cfg = Z3_mk_config();
+        slices[t] = (body_slice){Z3_mk_context_rc(cfg), view, copy, length,
+                                 (length + 1) * t / num_threads, (length + 1) * (t + 1) / num_threads,
+                                 num_nodes * t / num_threads, num_nodes * (t + 1) / num_threads, NULL, false};
+        Z3_del_config(cfg);
+        // Sans thread disponible, la tranche est construite par le thread appelant
+        threaded[t] = pthread_create(&threads[t], NULL, build_body_slice, &slices[t]) == 0;
+        if (!threaded[t])
+        {
+            encoding_capped = encoding_capped || tn_memory_exceeded();
+            build_body_slice(&slices[t]);
+        }
+    }
+    Z3_ast stack = formula_stack_evolution(ctx, view, copy, length);
+
+    // Fusion en une passe : chaque tranche est traduite dans ctx, puis son contexte est détruit
+    Z3_ast *parts = malloc((num_threads + 1) * sizeof(Z3_ast));
+    parts[0] = stack;
+    for (int t = 0; t < num_threads; t++)
+    {
+        if (threaded[t])
+            pthread_join(threads[t], NULL);
+        encoding_capped = encoding_capped || slices[t].capped;
+        tn_trace_span span = tn_trace_begin("Z3_translate", "encode");
+        parts[t + 1] = own(ctx, Z3_translate(slices[t].ctx, slices[t].formula, ctx));
+        tn_trace_end(span);
+        Z3_dec_ref(slices[t].ctx, slices[t].formula);
+        Z3_del_context(slices[t].ctx);
+    }
+
+    Z3_ast result = and_release(ctx, num_threads + 1, parts);
+    free(parts);
+    free(threaded);
+    free(threads);
+    free(slices);
+    return end_encoding(ctx, result);
+}
+
+/**
+ * formula_disjoint_simple_paths : Chemins simples et deux à deux disjoints (sauf aux extrémités)
+ *
+ * Extension de formula_simple_path à l'union des copies 0..num_paths-1 (num_paths copies, lengths[c] la
+ * longueur de la copie c) :
+ * - pour s et d (communs à tous les chemins) : AtMost(1, ...) sur chaque copie séparément
+ * - pour les autres nœuds : AtMost(1, {x^c_{node,pos,height} | toutes les copies c, positions, hauteurs})
+ * - l'arête directe s -> d n'a pas de nœud intérieur : AtMost(1, {x^c_{d,1,height} | copies c de longueur 1})
+ *
+ * param lengths = La longueur de chaque copie
+ */
+static Z3_ast formula_disjoint_simple_paths(Z3_context ctx,
+                                            const tn_view view,
+                                            int num_paths,
+                                            const int *lengths,
+                                            int s,
+                                            int d)
+{
+    int num_nodes = tn_view_num_nodes(view);
+
+    int max_vars = 0;
+    for (int c = 0; c < num_paths; c++)
+        max_vars += (lengths[c] + 1) * get_stack_size(lengths[c]);
+
+    Z3_ast *vars = malloc(max_vars * sizeof(Z3_ast));
+    Z3_ast *constraints = malloc((num_nodes + 2 * num_paths + 1) * sizeof(Z3_ast));
+    int k = 0;
+
+    for (int c = 0; c < num_paths; c++)
+    {
+        constraints[k++] = formula_simple_path_on_node(ctx, c, s, lengths[c], vars);
+        if (d != s)
+            constraints[k++] = formula_simple_path_on_node(ctx, c, d, lengths[c], vars);
+    }
+
+    // Deux chemins de longueur 1 seraient tous deux l'arête s -> d : un seul peut l'emprunter
+    int num_direct = 0;
+    for (int c = 0; c < num_paths; c++)
+        if (lengths[c] == 1 && d != s)
+            for (int h = 0; h < get_stack_size(1); h++)
+                vars[num_direct++] = own(ctx, tn_path_variable_copy(ctx, c, d, 1, h));
+    if (num_direct > 1)
+        constraints[k++] = own(ctx, Z3_mk_atmost(ctx, num_direct, vars, 1));
+    release(ctx, num_direct, vars);
+
+    for (int node = 0; node < num_nodes; node++)
+    {
+        if (node == s || node == d)
+            continue;
+
+        int n = 0;
+        for (int c = 0; c < num_paths; c++)
+        {
+            int stack_size = get_stack_size(lengths[c]);
+            for (int pos = 0; pos <= lengths[c]; pos++)
+                for (int h = 0; h < stack_size; h++)
+                    vars[n++] = own(ctx, tn_path_variable_copy(ctx, c, node, pos, h));
+        }
+        constraints[k++] = own(ctx, Z3_mk_atmost(ctx, n, vars, 1));
+        release(ctx, n, vars);
+    }
+
+    Z3_ast result = and_release(ctx, k, constraints);
+    free(vars);
+    free(constraints);
+    return result;
+}
+
+// Littéral choisissant la longueur length pour le chemin path de tn_disjoint_reduction
+static Z3_ast disjoint_length_guard(Z3_context ctx, int path, int length)
+{
+    char name[60];
+    snprintf(name, 60, "[disjoint %d] length %d", path, length);
+    return mk_bool_var(ctx, name);
+}
+
+// Chaque chemin a une copie par longueur : la copie du chemin path à la longueur length
+static int disjoint_copy(int max_length, int path, int length)
+{
+    return path * max_length + length - 1;
+}
+
+/**
+ * formula_unused_copy : Une copie dont la longueur n'est pas choisie n'occupe aucun nœud
+ *
+ * NOT guard -> AND_{node,pos,height} NOT x^copy_{node,pos,height}, pour que les contraintes de disjonction sur
+ * l'union des copies ne portent que sur les longueurs choisies.
+ */
+static Z3_ast formula_unused_copy(Z3_context ctx, const tn_view view, int copy, int length, Z3_ast guard)
 {
+    int num_nodes = tn_view_num_nodes(view);
+    int stack_size = get_stack_size(length);
+    Z3_ast *negations = malloc((length + 1) * num_nodes * stack_size * sizeof(Z3_ast));
+    int k = 0;
+
+    for (int node = 0; node < num_nodes; node++)
+        for (int pos = 0; pos <= length; pos++)
+            for (int h = 0; h < stack_size; h++)
+                negations[k++] = own(ctx, Z3_mk_not(ctx, tn_path_variable_copy(ctx, copy, node, pos, h)));
+
+    Z3_ast parts[2] = {own(ctx, guard), and_release(ctx, k, negations)};
+    free(negations);
+    return or_release(ctx, 2, parts);
+}
+
+/**
+ * Réduction pour num_paths chemins de s à d deux à deux disjoints, chacun d'une longueur de 1 à max_length
+ *
+ * Comme dans TunnelFailure, chaque longueur de chaque chemin a sa copie, activée par sa garde, et chaque chemin
+ * a au moins une garde vraie. Les copies non choisies sont vides (formula_unused_copy), la disjonction est donc
+ * celle de formula_disjoint_simple_paths sur toutes les copies.
+ */
+Z3_ast tn_disjoint_reduction(Z3_context ctx, const TunnelNetwork network, int num_paths, int max_length)
+{
+    int s = tn_get_initial(network);
+    int d = tn_get_final(network);
+    tn_view view = tn_view_from_network(network);
+    int num_copies = num_paths * max_length;
+
+    int *lengths = malloc((num_copies > 0 ? num_copies : 1) * sizeof(int));
+    Z3_ast *guards = malloc((max_length > 0 ? max_length : 1) * sizeof(Z3_ast));
+    Z3_ast *parts = malloc((2 * num_copies + num_paths + 1) * sizeof(Z3_ast));
+    int k = 0;
+
+    begin_encoding();
+    for (int c = 0; c < num_paths; c++)
+    {
+        for (int length = 1; length <= max_length; length++)
+        {
+            int copy = disjoint_copy(max_length, c, length);
+            lengths[copy] = length;
+
+            Z3_ast path[3] = {formula_initial_and_final_positions(ctx, view, copy, s, d, length, true, true),
+                              formula_unique_node_per_position(ctx, view, copy, length),
+                              formula_valid_transitions(ctx, view, copy, length, false)};
+            Z3_ast implication[2] = {own(ctx, Z3_mk_not(ctx, disjoint_length_guard(ctx, c, length))),
+                                     and_release(ctx, 3, path)};
+            parts[k++] = or_release(ctx, 2, implication);
+            parts[k++] = formula_unused_copy(ctx, view, copy, length, disjoint_length_guard(ctx, c, length));
+            guards[length - 1] = own(ctx, disjoint_length_guard(ctx, c, length));
+        }
+        parts[k++] = or_release(ctx, max_length, guards);
+    }
+    parts[k++] = formula_disjoint_simple_paths(ctx, view, num_copies, lengths, s, d);
+
+    Z3_ast result = and_release(ctx, k, parts);
+    free(parts);
+    free(guards);
+    free(lengths);
+    tn_view_delete(view);
+    return end_encoding(ctx, result);
+}
+
+// Lit les num_paths chemins disjoints dans le modèle, chacun à la plus courte de ses longueurs choisies
+
+void tn_get_disjoint_paths_from_model(Z3_context ctx, Z3_model model, TunnelNetwork network, int num_paths, int max_length, tn_step **paths, int *lengths)
+{
+    for (int c = 0; c < num_paths; c++)
+    {
+        int length = 1;
+        while (length < max_length && !value_of_var_in_model(ctx, model, disjoint_length_guard(ctx, c, length)))
+            length++;
+        lengths[c] = length;
+        tn_get_path_from_model_copy(ctx, model, network, disjoint_copy(max_length, c, length), length, paths[c]);
+    }
+}
+
+// Réduction sans les transitions du graphe : tout ce qui ne dépend ni des arêtes ni des actions
+Z3_ast tn_reduction_skeleton_copy(Z3_context ctx, const TunnelNetwork network, int copy, int source, int target, int length)
+{
+    tn_view view = tn_view_from_network(network);
     Z3_ast parts[4];
     int k = 0;
 
-    parts[k++] = formula_initial_and_final_positions(ctx, network, length);
-    parts[k++] = formula_unique_node_per_position(ctx, network, length);
-    parts[k++] = formula_simple_path(ctx, network, length);
-    parts[k++] = formula_valid_transitions(ctx, network, length);
+    begin_encoding();
+    parts[k++] = formula_initial_and_final_positions(ctx, view, copy, source, target, length, true, true);
+    parts[k++] = formula_unique_node_per_position(ctx, view, copy, length);
+    parts[k++] = formula_simple_path(ctx, view, copy, length);
+    parts[k++] = formula_stack_evolution(ctx, view, copy, length);
 
-    return Z3_mk_and(ctx, k, parts);
+    tn_view_delete(view);
+    return end_encoding(ctx, and_release(ctx, k, parts));
+}
+
+// Transitions depuis un nœud, ses successeurs et ses actions étant donnés explicitement
+Z3_ast tn_node_transitions_copy(Z3_context ctx, int copy, int node, int num_successors, const int *successors,
+                                int num_actions, const action *actions, int length)
+{
+    unsigned mask = 0;
+    for (int i = 0; i < num_actions; i++)
+        for (int a = 0; a < NUM_STACK_ACTIONS; a++)
+            if (stack_actions[a].act == actions[i])
+                mask |= 1u << a;
+    return formula_transitions_from_node(ctx, copy, node, num_successors, successors, mask, 0, length, length, false);
+}
+
+// Partie de la réduction qui ne regarde que les nœuds : unicité par position et chemin simple
+Z3_ast tn_path_structure_copy(Z3_context ctx, const TunnelNetwork network, int copy, int length)
+{
+    begin_encoding();
+    tn_view view = tn_view_from_network(network);
+    Z3_ast parts[2] = {formula_unique_node_per_position(ctx, view, copy, length),
+                       formula_simple_path(ctx, view, copy, length)};
+    tn_view_delete(view);
+    return end_encoding(ctx, and_release(ctx, 2, parts));
+}
+
+// Nombre de groupes de tn_reduction_groups : initial, final, simple path, et par position unicité, pile, transitions
+int tn_reduction_num_groups(int length)
+{
+    return 3 + 2 * (length + 1) + length;
+}
+
+// tn_reduction découpée en groupes étiquetés par sous-formule et par position
+int tn_reduction_groups(Z3_context ctx, const TunnelNetwork network, int length, tn_formula_group *groups)
+{
+    int s = tn_get_initial(network);
+    int d = tn_get_final(network);
+    tn_view view = tn_view_from_network(network);
+    int k = 0;
+
+    begin_encoding();
+    groups[k++] = (tn_formula_group){tn_group_initial, 0,
+                                     formula_initial_and_final_positions(ctx, view, 0, s, d, length, true, false)};
+    groups[k++] = (tn_formula_group){tn_group_final, length,
+                                     formula_initial_and_final_positions(ctx, view, 0, s, d, length, false, true)};
+    groups[k++] = (tn_formula_group){tn_group_simple_path, -1, formula_simple_path(ctx, view, 0, length)};
+
+    for (int pos = 0; pos <= length; pos++)
+    {
+        groups[k++] = (tn_formula_group){tn_group_unique, pos, formula_unique_node_at_position(ctx, view, 0, pos, length)};
+
+        // La pile à la position pos, et sa recopie vers pos + 1
+        Z3_ast stack[2] = {formula_well_formed_stack_at(ctx, view, 0, pos, length), own(ctx, Z3_mk_true(ctx))};
+        if (pos < length)
+        {
+            Z3_dec_ref(ctx, stack[1]);
+            stack[1] = formula_stack_frame(ctx, view, 0, pos, length);
+        }
+        groups[k++] = (tn_formula_group){tn_group_stack, pos, and_release(ctx, 2, stack)};
+
+        if (pos < length)
+            groups[k++] = (tn_formula_group){tn_group_transitions, pos, formula_transitions_at_position(ctx, view, 0, pos, length)};
+    }
+    tn_view_delete(view);
+
+    // Un groupe incomplet (chemin simple arrêté par la limite) : aucun groupe n'est rendu
+    if (end_encoding_capped())
+    {
+        for (int i = 0; i < k; i++)
+            Z3_dec_ref(ctx, groups[i].formula);
+        return -1;
+    }
+    return k;
+}
+
+// Fonction qui permet de construire la reduction
+
+Z3_ast tn_reduction(Z3_context ctx, const TunnelNetwork network, int length)
+{
+    return tn_reduction_copy(ctx, network, 0, tn_get_initial(network), tn_get_final(network), length);
 }
 
 // Lisent le chemin dans le modèle
 
 void tn_get_path_from_model(Z3_context ctx, Z3_model model, TunnelNetwork network, int bound, tn_step *path)
 {
-    int num_nodes = tn_get_num_nodes(network);
+    tn_get_path_from_model_copy(ctx, model, network, 0, bound, path);
+}
+
+// Lit le chemin de la copie copy dans le modèle
+
+static void path_from_model(Z3_context ctx, Z3_model model, int num_nodes, int copy, int bound, tn_step *path)
+{
+    tn_trace_span span = tn_trace_begin("tn_get_path_from_model", "decode");
     int stack_size = get_stack_size(bound);
     for (int pos = 0; pos < bound; pos++)
     {
@@ -280,12 +1288,12 @@ void tn_get_path_from_model(Z3_context ctx, Z3_model model, TunnelNetwork networ
         {
             for (int height = 0; height < stack_size; height++)
             {
-                if (value_of_var_in_model(ctx, model, tn_path_variable(ctx, n, pos, height)))
+                if (value_of_var_in_model(ctx, model, tn_path_variable_copy(ctx, copy, n, pos, height)))
                 {
                     src = n;
                     src_height = height;
                 }
-                if (value_of_var_in_model(ctx, model, tn_path_variable(ctx, n, pos + 1, height)))
+                if (value_of_var_in_model(ctx, model, tn_path_variable_copy(ctx, copy, n, pos + 1, height)))
                 {
                     tgt = n;
                     tgt_height = height;
@@ -295,21 +1303,21 @@ void tn_get_path_from_model(Z3_context ctx, Z3_model model, TunnelNetwork networ
         int action = 0;
         if (src_height == tgt_height)
         {
-            if (value_of_var_in_model(ctx, model, tn_4_variable(ctx, pos, src_height)))
+            if (value_of_var_in_model(ctx, model, tn_4_variable_copy(ctx, copy, pos, src_height)))
                 action = transmit_4;
             else
                 action = transmit_6;
         }
         else if (src_height == tgt_height - 1)
         {
-            if (value_of_var_in_model(ctx, model, tn_4_variable(ctx, pos, src_height)))
+            if (value_of_var_in_model(ctx, model, tn_4_variable_copy(ctx, copy, pos, src_height)))
             {
-                if (value_of_var_in_model(ctx, model, tn_4_variable(ctx, pos + 1, tgt_height)))
+                if (value_of_var_in_model(ctx, model, tn_4_variable_copy(ctx, copy, pos + 1, tgt_height)))
                     action = push_4_4;
                 else
                     action = push_4_6;
             }
-            else if (value_of_var_in_model(ctx, model, tn_4_variable(ctx, pos + 1, tgt_height)))
+            else if (value_of_var_in_model(ctx, model, tn_4_variable_copy(ctx, copy, pos + 1, tgt_height)))
                 action = push_6_4;
             else
                 action = push_6_6;
@@ -317,14 +1325,14 @@ void tn_get_path_from_model(Z3_context ctx, Z3_model model, TunnelNetwork networ
         else if (src_height == tgt_height + 1)
         {
             {
-                if (value_of_var_in_model(ctx, model, tn_4_variable(ctx, pos, src_height)))
+                if (value_of_var_in_model(ctx, model, tn_4_variable_copy(ctx, copy, pos, src_height)))
                 {
-                    if (value_of_var_in_model(ctx, model, tn_4_variable(ctx, pos + 1, tgt_height)))
+                    if (value_of_var_in_model(ctx, model, tn_4_variable_copy(ctx, copy, pos + 1, tgt_height)))
                         action = pop_4_4;
                     else
                         action = pop_6_4;
                 }
-                else if (value_of_var_in_model(ctx, model, tn_4_variable(ctx, pos + 1, tgt_height)))
+                else if (value_of_var_in_model(ctx, model, tn_4_variable_copy(ctx, copy, pos + 1, tgt_height)))
                     action = pop_4_6;
                 else
                     action = pop_6_6;
@@ -332,12 +1340,25 @@ void tn_get_path_from_model(Z3_context ctx, Z3_model model, TunnelNetwork networ
         }
         path[pos] = tn_step_create(action, src, tgt);
     }
+    tn_trace_end(span);
+    tn_memory_phase("tn_get_path_from_model");
+}
+
+void tn_get_path_from_model_copy(Z3_context ctx, Z3_model model, TunnelNetwork network, int copy, int bound, tn_step *path)
+{
+    path_from_model(ctx, model, tn_get_num_nodes(network), copy, bound, path);
+}
+
+void tn_view_get_path_from_model_copy(Z3_context ctx, Z3_model model, const tn_view view, int copy, int bound, tn_step *path)
+{
+    path_from_model(ctx, model, tn_view_num_nodes(view), copy, bound, path);
 }
 
 // Fonction qui affiche le modèle
 
 void tn_print_model(Z3_context ctx, Z3_model model, TunnelNetwork network, int bound)
 {
+    tn_trace_span span = tn_trace_begin("tn_print_model", "decode");
     int num_nodes = tn_get_num_nodes(network);
     int stack_size = get_stack_size(bound);
     for (int pos = 0; pos < bound + 1; pos++)
@@ -396,5 +1417,6 @@ void tn_print_model(Z3_context ctx, Z3_model model, TunnelNetwork network, int b
         if (misdefined)
             printf("Warning: ill-defined stack\n");
     }
+    tn_trace_end(span);
     return;
 }
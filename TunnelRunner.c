@@ -0,0 +1,278 @@
+#include "TunnelRunner.h"
+#include "TunnelCommon.h"
+#include "TunnelSession.h"
+#include "TunnelTrace.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include <pthread.h>
+
+// ===== MANIFESTE =====
+
+static char *endpoint(const char *word)
+{
+    return strcmp(word, "-") == 0 ? NULL : strdup(word);
+}
+
+int tn_runner_read_manifest(const char *filename, tn_job **jobs)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        perror(filename);
+        return -1;
+    }
+
+    int num_jobs = 0;
+    int max_jobs = 64;
+    *jobs = malloc(max_jobs * sizeof(tn_job));
+    char *line = NULL;
+    size_t size = 0;
+    int line_number = 0;
+    while (getline(&line, &size, file) >= 0)
+    {
+        line_number++;
+        char network[4096], source[1024], target[1024];
+        int max_length;
+        char first;
+        if (sscanf(line, " %c", &first) != 1 || first == '#')
+            continue;
+        if (sscanf(line, "%4095s %1023s %1023s %d", network, source, target, &max_length) != 4 || max_length <= 0)
+        {
+            fprintf(stderr, "%s:%d: expected \"<file> <source> <target> <max_length>\"\n", filename, line_number);
+            tn_runner_free_jobs(num_jobs, *jobs);
+            free(line);
+            fclose(file);
+            return -1;
+        }
+        if (num_jobs == max_jobs)
+        {
+            max_jobs *= 2;
+            *jobs = realloc(*jobs, max_jobs * sizeof(tn_job));
+        }
+        (*jobs)[num_jobs++] = (tn_job){strdup(network), endpoint(source), endpoint(target), max_length};
+    }
+    free(line);
+    fclose(file);
+    return num_jobs;
+}
+
+void tn_runner_free_jobs(int num_jobs, tn_job *jobs)
+{
+    for (int i = 0; i < num_jobs; i++)
+    {
+        free(jobs[i].filename);
+        free(jobs[i].source);
+        free(jobs[i].target);
+    }
+    free(jobs);
+}
+
+// ===== POOL DE THREADS =====
+
+// File de jobs d'un worker : order[front .. back - 1], le propriétaire prend à l'avant, les voleurs à l'arrière
+typedef struct
+{
+    pthread_mutex_t lock;
+    int front;
+    int back;
+} deque;
+
+typedef struct
+{
+    const tn_job *jobs;
+    tn_job_result *results;
+    const int *order;
+    deque *deques;
+    int num_threads;
+} pool;
+
+typedef struct
+{
+    pool *pool;
+    int id;
+} worker;
+
+static int take_front(deque *d)
+{
+    pthread_mutex_lock(&d->lock);
+    int job = d->front < d->back ? d->front++ : -1;
+    pthread_mutex_unlock(&d->lock);
+    return job;
+}
+
+static int steal_back(deque *d)
+{
+    pthread_mutex_lock(&d->lock);
+    int job = d->front < d->back ? --d->back : -1;
+    pthread_mutex_unlock(&d->lock);
+    return job;
+}
+
+// Prochain indice dans order : d'abord la file du worker, puis celles des autres
+static int next_job(pool *p, int id)
+{
+    int slot = take_front(&p->deques[id]);
+    for (int k = 1; slot < 0 && k < p->num_threads; k++)
+        slot = steal_back(&p->deques[(id + k) % p->num_threads]);
+    return slot < 0 ? -1 : p->order[slot];
+}
+
+static tn_job_status run_job(tn_session session, const tn_job *job, int *length)
+{
+    if (session == NULL)
+        return tn_job_error;
+    int source = job->source == NULL ? tn_session_initial(session) : tn_session_find_node(session, job->source);
+    int target = job->target == NULL ? tn_session_final(session) : tn_session_find_node(session, job->target);
+    if (source < 0 || target < 0)
+        return tn_job_error;
+
+    tn_step *path = malloc(job->max_length * sizeof(tn_step));
+    tn_session_result result = tn_session_solve(session, source, target, job->max_length, path, length);
+    free(path);
+    switch (result)
+    {
+    case tn_session_sat:
+        return tn_job_sat;
+    case tn_session_unsat:
+        return tn_job_unsat;
+    default:
+        return tn_job_unknown;
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    worker *w = arg;
+    pool *p = w->pool;
+    tn_session session = NULL;
+    const char *session_file = NULL;
+    char lane[32];
+    snprintf(lane, sizeof(lane), "worker %d", w->id);
+    tn_trace_name_thread(lane);
+
+    for (int j = next_job(p, w->id); j >= 0; j = next_job(p, w->id))
+    {
+        const tn_job *job = &p->jobs[j];
+        double start = tn_now();
+        tn_trace_span span = tn_trace_begin("job", "runner");
+
+        // La session est gardée tant que les jobs portent sur le même fichier
+        if (session_file == NULL || strcmp(session_file, job->filename) != 0)
+        {
+            if (session != NULL)
+                tn_session_close(session);
+            session = tn_session_open(job->filename);
+            session_file = job->filename;
+        }
+
+        tn_job_result *result = &p->results[j];
+        result->length = 0;
+        result->status = run_job(session, job, &result->length);
+        result->seconds = tn_now() - start;
+        tn_trace_end(span);
+    }
+
+    if (session != NULL)
+        tn_session_close(session);
+    return NULL;
+}
+
+// Clé de tri d'un job : son fichier, puis son rang pour garder l'ordre d'origine dans un même fichier
+typedef struct
+{
+    const char *filename;
+    int index;
+} job_key;
+
+static int compare_files(const void *a, const void *b)
+{
+    const job_key *x = a;
+    const job_key *y = b;
+    int c = strcmp(x->filename, y->filename);
+    return c != 0 ? c : x->index - y->index;
+}
+
+double tn_runner_run(int num_jobs, const tn_job *jobs, int num_threads, tn_job_result *results)
+{
+    double start = tn_now();
+    if (num_threads < 1)
+        num_threads = 1;
+
+    // Les jobs d'un même fichier sont consécutifs, donc en général dans la file d'un seul worker
+    job_key *keys = malloc((num_jobs > 0 ? num_jobs : 1) * sizeof(job_key));
+    for (int i = 0; i < num_jobs; i++)
+        keys[i] = (job_key){jobs[i].filename, i};
+    qsort(keys, num_jobs, sizeof(job_key), compare_files);
+    int *order = malloc((num_jobs > 0 ? num_jobs : 1) * sizeof(int));
+    for (int i = 0; i < num_jobs; i++)
+        order[i] = keys[i].index;
+    free(keys);
+
+    pool p = {jobs, results, order, malloc(num_threads * sizeof(deque)), num_threads};
+    worker *workers = malloc(num_threads * sizeof(worker));
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    for (int t = 0; t < num_threads; t++)
+    {
+        pthread_mutex_init(&p.deques[t].lock, NULL);
+        p.deques[t].front = (int)((long long)num_jobs * t / num_threads);
+        p.deques[t].back = (int)((long long)num_jobs * (t + 1) / num_threads);
+        workers[t] = (worker){&p, t};
+    }
+    int num_started = 0;
+    while (num_started < num_threads && pthread_create(&threads[num_started], NULL, worker_main, &workers[num_started]) == 0)
+        num_started++;
+    // Sans thread disponible, le thread appelant est le premier worker manquant : il vole aussi les files des suivants
+    if (num_started < num_threads)
+        worker_main(&workers[num_started]);
+    for (int t = 0; t < num_started; t++)
+        pthread_join(threads[t], NULL);
+
+    for (int t = 0; t < num_threads; t++)
+        pthread_mutex_destroy(&p.deques[t].lock);
+    free(threads);
+    free(workers);
+    free(p.deques);
+    free(order);
+    return tn_now() - start;
+}
+
+// ===== RAPPORT =====
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentile par rang le plus proche sur un tableau trié
+static double percentile(const double *sorted, int n, double p)
+{
+    int rank = (int)(p / 100.0 * n + 0.999999);
+    if (rank < 1)
+        rank = 1;
+    return sorted[rank > n ? n - 1 : rank - 1];
+}
+
+void tn_runner_print_report(FILE *out, int num_jobs, const tn_job_result *results, double wall_seconds)
+{
+    int counts[4] = {0, 0, 0, 0};
+    double *latencies = malloc((num_jobs > 0 ? num_jobs : 1) * sizeof(double));
+    for (int i = 0; i < num_jobs; i++)
+    {
+        counts[results[i].status]++;
+        latencies[i] = results[i].seconds;
+    }
+    qsort(latencies, num_jobs, sizeof(double), compare_doubles);
+
+    fprintf(out, "Jobs: %d in %.3f s (%.1f jobs/s)\n", num_jobs, wall_seconds,
+            wall_seconds > 0 ? num_jobs / wall_seconds : 0.0);
+    fprintf(out, "SAT: %d, UNSAT: %d, UNKNOWN: %d, errors: %d\n", counts[tn_job_sat], counts[tn_job_unsat],
+            counts[tn_job_unknown], counts[tn_job_error]);
+    if (num_jobs > 0)
+        fprintf(out, "Latency (ms): p50 %.2f, p90 %.2f, p99 %.2f, max %.2f\n", 1000 * percentile(latencies, num_jobs, 50),
+                1000 * percentile(latencies, num_jobs, 90), 1000 * percentile(latencies, num_jobs, 99),
+                1000 * latencies[num_jobs - 1]);
+    free(latencies);
+}
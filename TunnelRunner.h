@@ -0,0 +1,88 @@
+#ifndef TUNNEL_RUNNER_H
+#define TUNNEL_RUNNER_H
+
+#include <stdio.h>
+
+/**
+ * @file TunnelRunner.h
+ * @brief Batch of tunnel queries over many network files, run on a pool of threads.
+ *
+ * Each worker thread has its own tn_session (hence its own Z3 context), reused while its jobs stay on the
+ * same file. The jobs are sorted by file and split into one contiguous deque per worker; a worker takes
+ * jobs from the front of its own deque and, when it is empty, steals from the back of the others.
+ */
+
+/**
+ * @brief A query: a path of length at most @p max_length from @p source to @p target in the network @p filename.
+ *
+ * A NULL source (resp. target) stands for the initial (resp. final) node of the network.
+ */
+typedef struct
+{
+    char *filename;
+    char *source;
+    char *target;
+    int max_length;
+} tn_job;
+
+/**
+ * @brief Outcome of a job.
+ */
+typedef enum
+{
+    tn_job_sat,
+    tn_job_unsat,
+    tn_job_unknown,
+    tn_job_error ///< The file cannot be loaded or a node does not exist.
+} tn_job_status;
+
+/**
+ * @brief Result of a job: its status, the length of the path found and the time spent (including loading).
+ */
+typedef struct
+{
+    tn_job_status status;
+    int length;
+    double seconds;
+} tn_job_result;
+
+/**
+ * @brief Reads a manifest: one job per line "<file> <source> <target> <max_length>", "-" for the default
+ * endpoints. Empty lines and lines starting with '#' are ignored.
+ *
+ * @param filename The manifest.
+ * @param jobs The jobs read, to free with tn_runner_free_jobs.
+ * @return int The number of jobs, or -1 on error (a message is printed on stderr).
+ */
+int tn_runner_read_manifest(const char *filename, tn_job **jobs);
+
+/**
+ * @brief Frees the jobs of tn_runner_read_manifest.
+ *
+ * @param num_jobs The number of jobs.
+ * @param jobs The jobs.
+ */
+void tn_runner_free_jobs(int num_jobs, tn_job *jobs);
+
+/**
+ * @brief Runs the jobs on @p num_threads threads.
+ *
+ * @param num_jobs The number of jobs.
+ * @param jobs The jobs.
+ * @param num_threads The number of worker threads (at least 1).
+ * @param results The result of each job, in the order of @p jobs.
+ * @return double The wall-clock time of the whole batch, in seconds.
+ */
+double tn_runner_run(int num_jobs, const tn_job *jobs, int num_threads, tn_job_result *results);
+
+/**
+ * @brief Prints the throughput, the SAT/UNSAT/UNKNOWN/error counts and the latency percentiles of a batch.
+ *
+ * @param out The output stream.
+ * @param num_jobs The number of jobs.
+ * @param results The results of tn_runner_run.
+ * @param wall_seconds The wall-clock time returned by tn_runner_run.
+ */
+void tn_runner_print_report(FILE *out, int num_jobs, const tn_job_result *results, double wall_seconds);
+
+#endif
@@ -0,0 +1,92 @@
+#include "TunnelSearch.h"
+#include "TunnelCommon.h"
+#include "stdlib.h"
+
+typedef struct
+{
+    tn_view view;
+    int target;
+    int *stack;
+    bool *visited;
+    tn_step *path;
+    long steps;
+    long max_steps;
+} search_state;
+
+// Un chemin de exactement remaining pas depuis u, la pile étant stack[0..height]
+static bool search_from(search_state *st, int u, int pos, int remaining, int height)
+{
+    if (remaining == 0)
+        return u == st->target && height == 0 && st->stack[0] == 4;
+
+    int num_successors;
+    const int *successors = tn_view_successors(st->view, u, &num_successors);
+    for (int a = 0; a < TN_NUM_ACTIONS; a++)
+    {
+        action act = tn_all_actions[a];
+        if (!tn_view_node_has_action(st->view, u, act))
+            continue;
+
+        // Effet de l'action sur la pile (a↑ab empile b sur a, ab↓a dépile b)
+        int top = st->stack[height];
+        int new_height = height;
+        int new_top;
+        if (act == transmit_4 || act == transmit_6)
+        {
+            if (top != (act == transmit_4 ? 4 : 6))
+                continue;
+            new_top = top;
+        }
+        else if (act == push_4_4 || act == push_4_6 || act == push_6_4 || act == push_6_6)
+        {
+            if (top != (act == push_4_4 || act == push_4_6 ? 4 : 6) || height + 1 > remaining - 1)
+                continue;
+            new_height = height + 1;
+            new_top = act == push_4_4 || act == push_6_4 ? 4 : 6;
+        }
+        else
+        {
+            int popped = act == pop_4_6 || act == pop_6_6 ? 6 : 4;
+            int below = act == pop_4_4 || act == pop_4_6 ? 4 : 6;
+            if (height == 0 || top != popped || st->stack[height - 1] != below)
+                continue;
+            new_height = height - 1;
+            new_top = below;
+        }
+
+        for (int i = 0; i < num_successors; i++)
+        {
+            int v = successors[i];
+            if (st->visited[v])
+                continue;
+            if (st->max_steps > 0 && ++st->steps > st->max_steps)
+                return false;
+            int saved = st->stack[new_height];
+            st->stack[new_height] = new_top;
+            st->visited[v] = true;
+            st->path[pos] = (tn_step){act, u, v};
+            bool found = search_from(st, v, pos + 1, remaining - 1, new_height);
+            st->visited[v] = false;
+            st->stack[new_height] = saved;
+            if (found)
+                return true;
+        }
+    }
+    return false;
+}
+
+tn_search_result tn_view_search_path(const tn_view view, int source, int target, int length, long max_steps,
+                                     tn_step *path)
+{
+    int num_nodes = tn_view_num_nodes(view);
+    search_state st = {view, target, malloc((length + 2) * sizeof(int)), calloc(num_nodes, sizeof(bool)), path, 0,
+                       max_steps};
+    st.stack[0] = 4;
+    st.visited[source] = true;
+    bool found = search_from(&st, source, 0, length, 0);
+    free(st.visited);
+    free(st.stack);
+    if (found)
+        return tn_search_found;
+    return max_steps > 0 && st.steps > max_steps ? tn_search_gave_up : tn_search_none;
+}
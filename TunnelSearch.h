@@ -0,0 +1,40 @@
+#ifndef TUNNEL_SEARCH_H
+#define TUNNEL_SEARCH_H
+
+#include "TunnelNetwork.h"
+#include "TunnelView.h"
+
+/**
+ * @file TunnelSearch.h
+ * @brief Explicit-state search for a path, without SAT encoding.
+ *
+ * A depth-first search over (node, stack, visited nodes) that applies the actions of the nodes to an explicit
+ * stack. It needs memory linear in the number of nodes and the length, whatever the size of the reduction, but
+ * its time can be exponential: the number of steps can be bounded.
+ */
+
+/**
+ * @brief Outcome of a search.
+ */
+typedef enum
+{
+    tn_search_found,   ///< A path was found.
+    tn_search_none,    ///< There is no path of this length.
+    tn_search_gave_up  ///< The bound on the number of steps was reached first.
+} tn_search_result;
+
+/**
+ * @brief Looks for a valid simple path of exactly @p length steps from @p source to @p target.
+ *
+ * @param view A view of the network.
+ * @param source The first node of the path.
+ * @param target The last node of the path.
+ * @param length The length of the path.
+ * @param max_steps The maximal number of steps tried, 0 for no bound.
+ * @param path An array of tn_step of size at least @p length, filled if a path is found.
+ * @return tn_search_result
+ */
+tn_search_result tn_view_search_path(const tn_view view, int source, int target, int length, long max_steps,
+                                     tn_step *path);
+
+#endif
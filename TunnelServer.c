@@ -0,0 +1,450 @@
+#include "TunnelServer.h"
+#include "TunnelGraph.h"
+#include "TunnelSession.h"
+#include "errno.h"
+#include "limits.h"
+#include "stdlib.h"
+#include "string.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Une connexion sans commande ni lecture de réponse pendant ce temps est fermée
+#define CLIENT_TIMEOUT_SECONDS 600
+
+typedef struct
+{
+    char *name;
+    tn_session session;
+    pthread_mutex_t lock; // une requête à la fois sur la session et ses solveurs
+    int references;       // la table des réseaux et les commandes en cours, sous le verrou du serveur
+} loaded_network;
+
+struct tn_server_s
+{
+    loaded_network **networks;
+    int num_networks;
+    int max_networks;
+    atomic_bool shutdown;
+    pthread_mutex_t lock; // la table des réseaux et celle des clients
+    pthread_cond_t clients_done;
+    int listen_fd; // -1 hors de tn_server_listen
+    int *clients;  // sockets des clients servis, fermés en lecture à l'arrêt
+    int num_clients;
+    int max_clients;
+};
+
+tn_server tn_server_create(void)
+{
+    tn_server server = malloc(sizeof(struct tn_server_s));
+    server->num_networks = 0;
+    server->max_networks = 8;
+    server->networks = malloc(server->max_networks * sizeof(loaded_network *));
+    atomic_store(&server->shutdown, false);
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->clients_done, NULL);
+    server->listen_fd = -1;
+    server->num_clients = 0;
+    server->max_clients = 8;
+    server->clients = malloc(server->max_clients * sizeof(int));
+    return server;
+}
+
+static void free_network(loaded_network *network)
+{
+    tn_session_close(network->session);
+    pthread_mutex_destroy(&network->lock);
+    free(network->name);
+    free(network);
+}
+
+void tn_server_delete(tn_server server)
+{
+    for (int i = 0; i < server->num_networks; i++)
+        free_network(server->networks[i]);
+    free(server->networks);
+    free(server->clients);
+    pthread_cond_destroy(&server->clients_done);
+    pthread_mutex_destroy(&server->lock);
+    free(server);
+}
+
+// Index du réseau dans la table, -1 s'il n'est pas chargé (verrou du serveur tenu)
+static int find_network(tn_server server, const char *name)
+{
+    for (int i = 0; i < server->num_networks; i++)
+        if (strcmp(server->networks[i]->name, name) == 0)
+            return i;
+    return -1;
+}
+
+// Le réseau et une référence sur lui, qui le garde en vie même s'il est déchargé ou remplacé entre-temps
+static loaded_network *acquire_network(tn_server server, const char *name)
+{
+    pthread_mutex_lock(&server->lock);
+    int index = find_network(server, name);
+    loaded_network *network = index < 0 ? NULL : server->networks[index];
+    if (network != NULL)
+        network->references++;
+    pthread_mutex_unlock(&server->lock);
+    return network;
+}
+
+static void release_network(tn_server server, loaded_network *network)
+{
+    pthread_mutex_lock(&server->lock);
+    bool unused = --network->references == 0;
+    pthread_mutex_unlock(&server->lock);
+    if (unused)
+        free_network(network);
+}
+
+bool tn_server_load(tn_server server, const char *name, const char *filename)
+{
+    // Le chargement, long, se fait hors du verrou : les autres réseaux restent interrogeables
+    tn_session session = tn_session_open(filename);
+    if (session == NULL)
+        return false;
+    loaded_network *network = malloc(sizeof(loaded_network));
+    network->name = strdup(name);
+    network->session = session;
+    pthread_mutex_init(&network->lock, NULL);
+    network->references = 1;
+
+    pthread_mutex_lock(&server->lock);
+    int index = find_network(server, name);
+    loaded_network *replaced = index < 0 ? NULL : server->networks[index];
+    if (index < 0)
+    {
+        if (server->num_networks == server->max_networks)
+        {
+            server->max_networks *= 2;
+            server->networks = realloc(server->networks, server->max_networks * sizeof(loaded_network *));
+        }
+        index = server->num_networks++;
+    }
+    server->networks[index] = network;
+    pthread_mutex_unlock(&server->lock);
+
+    if (replaced != NULL)
+        release_network(server, replaced);
+    return true;
+}
+
+static bool unload_network(tn_server server, const char *name)
+{
+    pthread_mutex_lock(&server->lock);
+    int index = find_network(server, name);
+    loaded_network *network = index < 0 ? NULL : server->networks[index];
+    if (network != NULL)
+        server->networks[index] = server->networks[--server->num_networks];
+    pthread_mutex_unlock(&server->lock);
+
+    if (network == NULL)
+        return false;
+    release_network(server, network);
+    return true;
+}
+
+// Arrête tn_server_listen : plus de nouveau client, et les clients servis voient la fin de leur entrée
+static void stop_server(tn_server server)
+{
+    pthread_mutex_lock(&server->lock);
+    atomic_store(&server->shutdown, true);
+    if (server->listen_fd >= 0)
+        shutdown(server->listen_fd, SHUT_RDWR);
+    for (int i = 0; i < server->num_clients; i++)
+        shutdown(server->clients[i], SHUT_RD);
+    pthread_mutex_unlock(&server->lock);
+}
+
+static void query(tn_session session, int max_length, int source, int target, FILE *out)
+{
+    tn_step *path = malloc((max_length > 0 ? max_length : 1) * sizeof(tn_step));
+    int length = 0;
+
+    switch (tn_session_solve(session, source, target, max_length, path, &length))
+    {
+    case tn_session_sat:
+        fprintf(out, "sat %d %s", length, tn_session_node_name(session, path[0].source));
+        for (int i = 0; i < length; i++)
+            fprintf(out, " %s %s", tn_graph_action_label(path[i].action), tn_session_node_name(session, path[i].target));
+        fprintf(out, "\n");
+        break;
+    case tn_session_unsat:
+        fprintf(out, "unsat\n");
+        break;
+    default:
+    {
+        tn_session_bounds bounds;
+        tn_session_last_bounds(session, &bounds);
+        fprintf(out, "unknown %d %d\n", bounds.min_length, bounds.relaxed_length);
+        break;
+    }
+    }
+    free(path);
+}
+
+// Un nombre décimal sans signe qui tient dans un unsigned, rien d'autre sur le mot
+static bool parse_unsigned(const char *word, unsigned *value)
+{
+    if (*word < '0' || *word > '9')
+        return false;
+    char *end;
+    errno = 0;
+    unsigned long parsed = strtoul(word, &end, 10);
+    if (*end != '\0' || errno == ERANGE || parsed > UINT_MAX)
+        return false;
+    *value = (unsigned)parsed;
+    return true;
+}
+
+#define MAX_WORDS 6
+
+bool tn_server_handle_line(tn_server server, const char *line, FILE *out)
+{
+    char *copy = strdup(line);
+    char *words[MAX_WORDS];
+    int num_words = 0;
+    char *saveptr = NULL;
+    for (char *word = strtok_r(copy, " \t\r\n", &saveptr); word != NULL && num_words < MAX_WORDS;
+         word = strtok_r(NULL, " \t\r\n", &saveptr))
+        words[num_words++] = word;
+
+    bool keep_going = true;
+    if (num_words == 0)
+        ; // ligne vide : pas de réponse
+    else if (strcmp(words[0], "quit") == 0)
+        keep_going = false;
+    else if (strcmp(words[0], "shutdown") == 0)
+    {
+        stop_server(server);
+        keep_going = false;
+    }
+    else if (strcmp(words[0], "load") == 0 && num_words == 3)
+    {
+        loaded_network *network = tn_server_load(server, words[1], words[2]) ? acquire_network(server, words[1]) : NULL;
+        if (network != NULL)
+        {
+            fprintf(out, "ok %d\n", tn_session_num_nodes(network->session));
+            release_network(server, network);
+        }
+        else
+            fprintf(out, "error cannot load %s\n", words[2]);
+    }
+    else if (strcmp(words[0], "unload") == 0 && num_words == 2)
+    {
+        if (unload_network(server, words[1]))
+            fprintf(out, "ok\n");
+        else
+            fprintf(out, "error unknown network %s\n", words[1]);
+    }
+    else if (strcmp(words[0], "networks") == 0 && num_words == 1)
+    {
+        fprintf(out, "ok");
+        pthread_mutex_lock(&server->lock);
+        for (int i = 0; i < server->num_networks; i++)
+            fprintf(out, " %s", server->networks[i]->name);
+        pthread_mutex_unlock(&server->lock);
+        fprintf(out, "\n");
+    }
+    else if (strcmp(words[0], "budget") == 0 && (num_words == 3 || num_words == 4))
+    {
+        loaded_network *network = acquire_network(server, words[1]);
+        unsigned timeout_ms, max_conflicts = 0;
+        if (network == NULL)
+            fprintf(out, "error unknown network %s\n", words[1]);
+        else if (!parse_unsigned(words[2], &timeout_ms) || (num_words == 4 && !parse_unsigned(words[3], &max_conflicts)))
+        {
+            release_network(server, network);
+            fprintf(out, "error invalid budget\n");
+        }
+        else
+        {
+            pthread_mutex_lock(&network->lock);
+            tn_session_set_query_budget(network->session, timeout_ms, max_conflicts);
+            pthread_mutex_unlock(&network->lock);
+            release_network(server, network);
+            fprintf(out, "ok\n");
+        }
+    }
+    else if (strcmp(words[0], "query") == 0 && (num_words == 3 || num_words == 5))
+    {
+        loaded_network *network = acquire_network(server, words[1]);
+        char *end;
+        long requested = strtol(words[2], &end, 10);
+        if (network == NULL)
+            fprintf(out, "error unknown network %s\n", words[1]);
+        else
+        {
+            // Les requêtes sur un même réseau passent l'une après l'autre, celles sur d'autres réseaux en parallèle
+            pthread_mutex_lock(&network->lock);
+            tn_session session = network->session;
+            int source = num_words == 5 ? tn_session_find_node(session, words[3]) : tn_session_initial(session);
+            int target = num_words == 5 ? tn_session_find_node(session, words[4]) : tn_session_final(session);
+            if (source < 0 || target < 0)
+                fprintf(out, "error unknown node\n");
+            else if (*end != '\0' || requested <= 0)
+                fprintf(out, "error invalid length %s\n", words[2]);
+            else
+            {
+                // Pas plus long qu'un chemin simple : le tableau du chemin reste à la taille du réseau
+                int longest = tn_session_num_nodes(session) - 1;
+                query(session, requested < longest ? (int)requested : longest, source, target, out);
+            }
+            pthread_mutex_unlock(&network->lock);
+            release_network(server, network);
+        }
+    }
+    else
+        fprintf(out, "error invalid command\n");
+
+    fflush(out);
+    free(copy);
+    return keep_going;
+}
+
+void tn_server_run(tn_server server, FILE *in, FILE *out)
+{
+    char *line = NULL;
+    size_t size = 0;
+    while (getline(&line, &size, in) >= 0)
+        if (!tn_server_handle_line(server, line, out))
+            break;
+    free(line);
+}
+
+static void add_client(tn_server server, int client)
+{
+    pthread_mutex_lock(&server->lock);
+    if (server->num_clients == server->max_clients)
+    {
+        server->max_clients *= 2;
+        server->clients = realloc(server->clients, server->max_clients * sizeof(int));
+    }
+    server->clients[server->num_clients++] = client;
+    pthread_mutex_unlock(&server->lock);
+}
+
+// Retiré avant d'être fermé : stop_server ne touche jamais un descripteur réutilisé
+static void remove_client(tn_server server, int client)
+{
+    pthread_mutex_lock(&server->lock);
+    for (int i = 0; i < server->num_clients; i++)
+        if (server->clients[i] == client)
+            server->clients[i] = server->clients[--server->num_clients];
+    pthread_cond_signal(&server->clients_done);
+    pthread_mutex_unlock(&server->lock);
+}
+
+typedef struct
+{
+    tn_server server;
+    int fd;
+} connection;
+
+static void *serve_client(void *arg)
+{
+    connection *c = arg;
+    int output = dup(c->fd);
+    FILE *in = fdopen(c->fd, "r");
+    FILE *out = output < 0 ? NULL : fdopen(output, "w");
+    if (in == NULL || out == NULL)
+        perror("fdopen");
+    else
+        tn_server_run(c->server, in, out);
+
+    remove_client(c->server, c->fd);
+    if (out != NULL)
+        fclose(out);
+    else if (output >= 0)
+        close(output);
+    if (in != NULL)
+        fclose(in);
+    else
+        close(c->fd);
+    free(c);
+    return NULL;
+}
+
+int tn_server_listen(tn_server server, const char *socket_path)
+{
+    struct sockaddr_un address;
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "%s: socket path too long\n", socket_path);
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, 16) != 0)
+    {
+        perror(socket_path);
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    // Un client parti sans lire sa réponse ne doit pas tuer le serveur : l'écriture échoue avec EPIPE
+    signal(SIGPIPE, SIG_IGN);
+    atomic_store(&server->shutdown, false);
+    pthread_mutex_lock(&server->lock);
+    server->listen_fd = fd;
+    pthread_mutex_unlock(&server->lock);
+
+    // Un thread par client ; les sessions sont partagées, chacune sous son propre verrou
+    int status = 0;
+    while (!atomic_load(&server->shutdown))
+    {
+        int client = accept(fd, NULL, NULL);
+        if (client < 0)
+        {
+            if (atomic_load(&server->shutdown) || errno == EINTR || errno == ECONNABORTED)
+                continue;
+            perror(socket_path);
+            // Plus de descripteurs ou de mémoire : on attend que des clients partent
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+            {
+                usleep(100000);
+                continue;
+            }
+            status = -1;
+            break;
+        }
+
+        // Un client muet, ou qui ne lit pas ses réponses, est déconnecté au bout du délai
+        struct timeval timeout = {CLIENT_TIMEOUT_SECONDS, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        connection *c = malloc(sizeof(connection));
+        *c = (connection){server, client};
+        add_client(server, client);
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, serve_client, c) == 0)
+            pthread_detach(thread);
+        else
+            serve_client(c);
+    }
+
+    // Les clients encore servis finissent leur commande en cours
+    pthread_mutex_lock(&server->lock);
+    server->listen_fd = -1;
+    for (int i = 0; i < server->num_clients; i++)
+        shutdown(server->clients[i], SHUT_RD);
+    while (server->num_clients > 0)
+        pthread_cond_wait(&server->clients_done, &server->lock);
+    pthread_mutex_unlock(&server->lock);
+
+    close(fd);
+    unlink(socket_path);
+    return status;
+}
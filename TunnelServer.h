@@ -0,0 +1,90 @@
+#ifndef TUNNEL_SERVER_H
+#define TUNNEL_SERVER_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * @file TunnelServer.h
+ * @brief Long-running tunnel query server keeping networks loaded and encodings warm.
+ *
+ * Each loaded network is a tn_session, which keeps the view of the network and, for each length already
+ * queried, a solver in which the part of the reduction that does not depend on the endpoints is asserted.
+ * A query only pushes the endpoint constraints, checks and pops.
+ *
+ * Line protocol (one command per line, one answer line per command):
+ *   load <name> <file>                        ok <num_nodes>   (DOT file, or snapshot if not *.dot)
+ *   unload <name>                             ok
+ *   networks                                  ok <name> ...
+ *   budget <name> <ms> [<conflicts>]          ok               (per query, 0 for no limit, each fitting in unsigned)
+ *   query <name> <max_length> [<src> <dst>]   sat <length> <node> <action> <node> ... | unsat
+ *                                             | unknown <min_length> <relaxed_length>
+ *   quit                                      closes the connection
+ *   shutdown                                  closes the connection and stops tn_server_listen
+ * Errors are answered by "error <message>". Without <src> <dst>, the initial and final nodes of the network
+ * are used. The lengths 1 to <max_length> are tried in order, so the path returned is a shortest one; no length
+ * past the number of nodes minus one is tried, since a path visits each node at most once. A query
+ * over its budget answers unknown with the bounds of tn_session_last_bounds: no path is shorter than
+ * <min_length>, and no walk shorter than <relaxed_length> leads from <src> to <dst>.
+ */
+
+typedef struct tn_server_s *tn_server;
+
+/**
+ * @brief Creates a server with no network loaded.
+ *
+ * @return tn_server
+ */
+tn_server tn_server_create(void);
+
+/**
+ * @brief Frees a server, its networks and its solvers.
+ *
+ * @param server A server.
+ */
+void tn_server_delete(tn_server server);
+
+/**
+ * @brief Loads a network under the name @p name, replacing a network of the same name.
+ *
+ * @param server A server.
+ * @param name The name used in the queries.
+ * @param filename A DOT file (*.dot) or a snapshot of tn_graph_save_snapshot.
+ * @return true if the network was loaded.
+ */
+bool tn_server_load(tn_server server, const char *name, const char *filename);
+
+/**
+ * @brief Executes one command of the line protocol and writes its answer.
+ *
+ * @param server A server.
+ * @param line The command.
+ * @param out The stream of the answer.
+ * @return false if the command closes the connection (quit, shutdown).
+ */
+bool tn_server_handle_line(tn_server server, const char *line, FILE *out);
+
+/**
+ * @brief Answers the commands read on @p in until end of file or quit.
+ *
+ * @param server A server.
+ * @param in The commands, typically stdin.
+ * @param out The answers, flushed after each line.
+ */
+void tn_server_run(tn_server server, FILE *in, FILE *out);
+
+/**
+ * @brief Listens on a Unix domain socket and serves the clients until shutdown.
+ *
+ * Each client is served by its own thread. The queries on one network run one after the other, the queries on
+ * different networks in parallel. A client that sends no command, or does not read its answers, for 10 minutes
+ * is disconnected. SIGPIPE is ignored, so that a client leaving early only fails its own writes. On shutdown,
+ * the other clients finish their current command and are disconnected.
+ *
+ * @param server A server.
+ * @param socket_path The path of the socket (an existing file at that path is removed).
+ * @return 0 after shutdown, -1 if the socket cannot be created or accepting a client fails for good.
+ */
+int tn_server_listen(tn_server server, const char *socket_path);
+
+#endif
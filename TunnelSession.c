@@ -0,0 +1,404 @@
+#include "TunnelSession.h"
+#include "TunnelCommon.h"
+#include "TunnelEncoding.h"
+#include "TunnelEstimate.h"
+#include "TunnelGraph.h"
+#include "TunnelMemory.h"
+#include "TunnelProgress.h"
+#include "TunnelSearch.h"
+#include "TunnelTrace.h"
+#include "TunnelValidator.h"
+#include "TunnelView.h"
+#include "Z3Tools.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+struct tn_session_s
+{
+    Z3_context ctx;
+    tn_view view;
+    char **names;
+    Z3_solver *solvers; // solvers[length] : corps de la réduction déjà asserté, NULL si pas encore demandé
+    int max_length;
+    int num_threads; // threads de construction de l'encodage
+    bool has_budget;
+    tn_size_estimate budget; // au-delà, recherche explicite au lieu de l'encodage
+    long max_search_steps;
+    bool over_budget_reported;
+    unsigned timeout_ms;    // budget de temps d'une requête, 0 sans limite
+    unsigned max_conflicts; // budget de conflits d'une requête, 0 sans limite
+    atomic_bool interrupted;
+    pthread_mutex_t check_lock; // partagé par tn_session_interrupt et l'entrée dans un appel au solveur
+    pthread_cond_t check_done;
+    bool checking; // un appel au solveur est en cours, sous check_lock
+    tn_session_bounds bounds; // bornes de la dernière requête
+};
+
+static tn_session session_create(tn_view view)
+{
+    tn_session session = malloc(sizeof(struct tn_session_s));
+    // Contexte à compteurs de références : les formules intermédiaires de l'encodage sont libérées au fur et à
+    // mesure au lieu de vivre aussi longtemps que la session
+    Z3_config cfg = Z3_mk_config();
+    session->ctx = Z3_mk_context_rc(cfg);
+    Z3_del_config(cfg);
+    session->view = view;
+    session->names = malloc(tn_view_num_nodes(view) * sizeof(char *));
+    session->max_length = 0;
+    session->solvers = calloc(1, sizeof(Z3_solver));
+    session->num_threads = 1;
+    session->has_budget = false;
+    session->over_budget_reported = false;
+    session->timeout_ms = 0;
+    session->max_conflicts = 0;
+    atomic_init(&session->interrupted, false);
+    pthread_mutex_init(&session->check_lock, NULL);
+    pthread_cond_init(&session->check_done, NULL);
+    session->checking = false;
+    session->bounds = (tn_session_bounds){0, -1};
+    return session;
+}
+
+static bool has_suffix(const char *s, const char *suffix)
+{
+    size_t n = strlen(s);
+    size_t m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+tn_session tn_session_open(const char *filename)
+{
+    tn_graph graph = has_suffix(filename, ".dot") ? tn_graph_load_dot(filename) : tn_graph_load_snapshot(filename);
+    if (graph == NULL)
+        return NULL;
+    tn_session session = tn_session_from_graph(graph);
+    tn_graph_delete(graph);
+    return session;
+}
+
+tn_session tn_session_from_graph(const tn_graph graph)
+{
+    tn_session session = session_create(tn_view_from_graph(graph));
+    for (int node = 0; node < tn_graph_num_nodes(graph); node++)
+        session->names[node] = strdup(tn_graph_node_name(graph, node));
+    return session;
+}
+
+tn_session tn_session_from_network(const TunnelNetwork network)
+{
+    tn_session session = session_create(tn_view_from_network(network));
+    for (int node = 0; node < tn_get_num_nodes(network); node++)
+        session->names[node] = strdup(tn_get_node_name(network, node));
+    return session;
+}
+
+void tn_session_close(tn_session session)
+{
+    for (int length = 0; length <= session->max_length; length++)
+        if (session->solvers[length] != NULL)
+            Z3_solver_dec_ref(session->ctx, session->solvers[length]);
+    free(session->solvers);
+    for (int node = 0; node < tn_view_num_nodes(session->view); node++)
+        free(session->names[node]);
+    free(session->names);
+    tn_view_delete(session->view);
+    Z3_del_context(session->ctx);
+    pthread_cond_destroy(&session->check_done);
+    pthread_mutex_destroy(&session->check_lock);
+    free(session);
+}
+
+int tn_session_num_nodes(const tn_session session)
+{
+    return tn_view_num_nodes(session->view);
+}
+
+int tn_session_initial(const tn_session session)
+{
+    return tn_view_initial(session->view);
+}
+
+int tn_session_final(const tn_session session)
+{
+    return tn_view_final(session->view);
+}
+
+const char *tn_session_node_name(const tn_session session, int node)
+{
+    return session->names[node];
+}
+
+void tn_session_set_num_threads(tn_session session, int num_threads)
+{
+    session->num_threads = num_threads;
+}
+
+void tn_session_set_budget(tn_session session, const tn_size_estimate *budget, long max_search_steps)
+{
+    session->has_budget = budget != NULL;
+    if (budget != NULL)
+        session->budget = *budget;
+    session->max_search_steps = max_search_steps;
+    session->over_budget_reported = false;
+}
+
+void tn_session_set_query_budget(tn_session session, unsigned timeout_ms, unsigned max_conflicts)
+{
+    session->timeout_ms = timeout_ms;
+    session->max_conflicts = max_conflicts;
+}
+
+// Z3 ignore un Z3_interrupt reçu avant que l'appel au solveur ne soit enregistré : tant que l'appel n'est pas
+// revenu, l'interruption est répétée. Entre deux requêtes, le drapeau suffit, il est relu avant chaque appel.
+void tn_session_interrupt(tn_session session)
+{
+    pthread_mutex_lock(&session->check_lock);
+    atomic_store(&session->interrupted, true);
+    while (session->checking)
+    {
+        Z3_interrupt(session->ctx);
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += 1000000;
+        if (deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&session->check_done, &session->check_lock, &deadline);
+    }
+    pthread_mutex_unlock(&session->check_lock);
+}
+
+void tn_session_last_bounds(const tn_session session, tn_session_bounds *bounds)
+{
+    *bounds = session->bounds;
+}
+
+int tn_session_find_node(const tn_session session, const char *name)
+{
+    for (int node = 0; node < tn_view_num_nodes(session->view); node++)
+        if (strcmp(session->names[node], name) == 0)
+            return node;
+    return -1;
+}
+
+// Le solveur de la longueur length, créé et chargé du corps de la réduction à la première demande ; NULL si
+// l'encodage a dépassé la limite de mémoire
+static Z3_solver warm_solver(tn_session session, int length)
+{
+    if (length > session->max_length)
+    {
+        session->solvers = realloc(session->solvers, (length + 1) * sizeof(Z3_solver));
+        for (int l = session->max_length + 1; l <= length; l++)
+            session->solvers[l] = NULL;
+        session->max_length = length;
+    }
+    if (session->solvers[length] == NULL)
+    {
+        tn_progress_phase("encode", length);
+        Z3_solver solver = Z3_mk_solver(session->ctx);
+        Z3_solver_inc_ref(session->ctx, solver);
+        Z3_ast body = tn_view_parallel_reduction_body_copy(session->ctx, session->view, 0, length, session->num_threads);
+        if (body == NULL)
+        {
+            // Encodage arrêté par la limite de mémoire : pas de solveur pour cette longueur
+            Z3_solver_dec_ref(session->ctx, solver);
+            return NULL;
+        }
+        Z3_solver_assert(session->ctx, solver, body);
+        Z3_dec_ref(session->ctx, body);
+        session->solvers[length] = solver;
+    }
+    return session->solvers[length];
+}
+
+// Vrai si la réduction de longueur length dépasse le budget (signalé une fois par session)
+static bool over_budget(tn_session session, int length)
+{
+    if (!session->has_budget)
+        return false;
+    tn_size_estimate estimate;
+    tn_view_estimate_reduction(session->view, length, &estimate);
+    if (tn_estimate_within(&estimate, &session->budget))
+        return false;
+    if (!session->over_budget_reported)
+    {
+        fprintf(stderr,
+                "Reduction of length %d over budget (%" PRIu64 " variables, %" PRIu64 " clauses, %" PRIu64
+                " literals): explicit search from this length\n",
+                length, estimate.num_variables, estimate.num_clauses, estimate.num_literals);
+        session->over_budget_reported = true;
+    }
+    return true;
+}
+
+// Chaque chemin trouvé est rejoué sur le réseau avant d'être rendu
+static tn_session_result checked_path(tn_session session, int source, int target, int length, const tn_step *path)
+{
+    tn_path_check check = tn_view_check_path(session->view, source, target, length, path);
+    if (check.error == tn_path_valid)
+        return tn_session_sat;
+    fprintf(stderr, "Invalid path from the solver at step %d: %s\n", check.pos, tn_path_error_message(check.error));
+    return tn_session_unknown;
+}
+
+// Plus courte marche de source à target dans le graphe, sans la pile ni la simplicité du chemin : aucun chemin
+// n'est plus court. -1 si target est inaccessible.
+static int relaxed_distance(const tn_view view, int source, int target)
+{
+    int num_nodes = tn_view_num_nodes(view);
+    int *distance = malloc(num_nodes * sizeof(int));
+    int *queue = malloc(num_nodes * sizeof(int));
+    for (int node = 0; node < num_nodes; node++)
+        distance[node] = -1;
+    int head = 0, tail = 0;
+    distance[source] = 0;
+    queue[tail++] = source;
+    while (head < tail && distance[target] < 0)
+    {
+        int u = queue[head++];
+        // Un nœud sans action ne transmet rien
+        if (tn_view_node_actions(view, u) == 0)
+            continue;
+        int num_successors;
+        const int *successors = tn_view_successors(view, u, &num_successors);
+        for (int i = 0; i < num_successors; i++)
+            if (distance[successors[i]] < 0)
+            {
+                distance[successors[i]] = distance[u] + 1;
+                queue[tail++] = successors[i];
+            }
+    }
+    int result = distance[target];
+    free(queue);
+    free(distance);
+    return result;
+}
+
+// Fixe le reste des budgets de la requête sur le solveur avant un appel (0 : sans limite)
+static void set_check_budget(Z3_context ctx, Z3_solver solver, unsigned timeout_ms, unsigned max_conflicts)
+{
+    Z3_params params = Z3_mk_params(ctx);
+    Z3_params_inc_ref(ctx, params);
+    Z3_params_set_uint(ctx, params, Z3_mk_string_symbol(ctx, "timeout"), timeout_ms == 0 ? UINT_MAX : timeout_ms);
+    Z3_params_set_uint(ctx, params, Z3_mk_string_symbol(ctx, "max_conflicts"), max_conflicts == 0 ? UINT_MAX : max_conflicts);
+    Z3_solver_set_params(ctx, solver, params);
+    Z3_params_dec_ref(ctx, params);
+}
+
+tn_session_result tn_session_solve(tn_session session, int source, int target, int max_length, tn_step *path, int *length)
+{
+    Z3_context ctx = session->ctx;
+    double deadline = tn_now() + session->timeout_ms / 1000.0;
+    unsigned long conflicts = 0;
+    atomic_store(&session->interrupted, false);
+
+    // Un chemin simple passe au plus une fois par nœud : aucune longueur au-delà de num_nodes - 1 n'est essayée
+    int longest = tn_view_num_nodes(session->view) - 1;
+    if (max_length > longest)
+        max_length = longest;
+
+    // Les longueurs plus courtes que la marche la plus courte n'ont pas de chemin : elles ne sont pas encodées
+    int distance = relaxed_distance(session->view, source, target);
+    session->bounds = (tn_session_bounds){1, distance};
+    if (distance < 0 || distance > max_length)
+    {
+        session->bounds.min_length = max_length + 1;
+        return tn_session_unsat;
+    }
+
+    for (int l = distance > 1 ? distance : 1; l <= max_length; l++)
+    {
+        session->bounds.min_length = l;
+        double remaining = deadline - tn_now();
+        if (atomic_load(&session->interrupted) || (session->timeout_ms > 0 && remaining <= 0) ||
+            (session->max_conflicts > 0 && conflicts >= session->max_conflicts))
+            return tn_session_unknown;
+
+        if (over_budget(session, l))
+        {
+            tn_trace_span span = tn_trace_begin("tn_view_search_path", "solve");
+            tn_progress_phase("search", l);
+            tn_search_result found = tn_view_search_path(session->view, source, target, l, session->max_search_steps, path);
+            tn_progress_phase("idle", l);
+            tn_trace_end(span);
+            if (found == tn_search_gave_up)
+                return tn_session_unknown;
+            if (found == tn_search_found)
+            {
+                tn_progress_best_length(l);
+                *length = l;
+                return checked_path(session, source, target, l, path);
+            }
+            continue;
+        }
+
+        Z3_solver solver = warm_solver(session, l);
+        if (solver == NULL || (session->timeout_ms > 0 && deadline - tn_now() <= 0))
+            return tn_session_unknown;
+        tn_progress_phase("push", l);
+        Z3_solver_push(ctx, solver);
+        Z3_ast endpoints = tn_view_endpoints_copy(ctx, session->view, 0, source, target, l);
+        Z3_solver_assert(ctx, solver, endpoints);
+        Z3_dec_ref(ctx, endpoints);
+        // L'encodage d'une nouvelle longueur, puis le premier push qui charge le corps dans le solveur
+        // incrémental, ont pu consommer le reste du temps
+        remaining = deadline - tn_now();
+        if (session->timeout_ms > 0 && remaining <= 0)
+        {
+            Z3_solver_pop(ctx, solver, 1);
+            return tn_session_unknown;
+        }
+        set_check_budget(ctx, solver, session->timeout_ms == 0 ? 0 : (unsigned)(remaining * 1000) + 1,
+                         session->max_conflicts == 0 ? 0 : session->max_conflicts - conflicts);
+        // Une interruption arrivée pendant l'encodage ou le push serait perdue par Z3 : elle est relue ici, sous
+        // le verrou de tn_session_interrupt, qui répète ensuite Z3_interrupt tant que l'appel est en cours
+        pthread_mutex_lock(&session->check_lock);
+        bool interrupted = atomic_load(&session->interrupted);
+        session->checking = !interrupted;
+        pthread_mutex_unlock(&session->check_lock);
+        if (interrupted)
+        {
+            Z3_solver_pop(ctx, solver, 1);
+            return tn_session_unknown;
+        }
+        tn_trace_span span = tn_trace_begin("Z3_solver_check", "solve");
+        tn_progress_check_begin(ctx, solver, l, session->max_conflicts > 0);
+        Z3_lbool result = Z3_solver_check(ctx, solver);
+        pthread_mutex_lock(&session->check_lock);
+        session->checking = false;
+        pthread_cond_broadcast(&session->check_done);
+        pthread_mutex_unlock(&session->check_lock);
+        tn_check_stats check;
+        tn_progress_check_end(ctx, solver, &check);
+        char *statistics = tn_trace_z3_statistics(ctx, solver);
+        tn_trace_end_args(span, statistics);
+        free(statistics);
+        conflicts += check.conflicts;
+        tn_memory_phase("check");
+        if (result == Z3_L_TRUE)
+        {
+            Z3_model model = Z3_solver_get_model(ctx, solver);
+            Z3_model_inc_ref(ctx, model);
+            tn_view_get_path_from_model_copy(ctx, model, session->view, 0, l, path);
+            Z3_model_dec_ref(ctx, model);
+            tn_progress_best_length(l);
+            *length = l;
+        }
+        Z3_solver_pop(ctx, solver, 1);
+
+        if (result == Z3_L_TRUE)
+            return checked_path(session, source, target, l, path);
+        if (result == Z3_L_UNDEF)
+            return tn_session_unknown;
+    }
+    session->bounds.min_length = max_length + 1;
+    return tn_session_unsat;
+}
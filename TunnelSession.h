@@ -0,0 +1,167 @@
+#ifndef TUNNEL_SESSION_H
+#define TUNNEL_SESSION_H
+
+#include "TunnelEstimate.h"
+#include "TunnelGraph.h"
+#include "TunnelNetwork.h"
+#include <stdbool.h>
+
+/**
+ * @file TunnelSession.h
+ * @brief Embeddable tunnel queries: load a network once, then ask for paths between any two nodes.
+ *
+ * A session owns its network view, its own Z3 context and one solver per length already queried, in which the
+ * endpoint-independent part of the reduction is asserted (tn_view_reduction_body_copy). A query only pushes
+ * the endpoint constraints, checks and pops, so the encoding is built once per length for the whole session.
+ *
+ * Sessions share no state: different sessions can be used concurrently from different threads. A single
+ * session must not be used by two threads at the same time.
+ */
+
+typedef struct tn_session_s *tn_session;
+
+/**
+ * @brief Result of a query.
+ */
+typedef enum
+{
+    tn_session_sat,    ///< A path was found.
+    tn_session_unsat,  ///< No path of length at most the bound.
+    tn_session_unknown ///< The solver gave up before concluding.
+} tn_session_result;
+
+/**
+ * @brief What the last query established, also when it answered tn_session_unknown.
+ */
+typedef struct
+{
+    int min_length;     ///< No path is shorter: the lengths below were refuted.
+    int relaxed_length; ///< Length of a shortest walk ignoring the stack and the simplicity of the path, -1 if none.
+} tn_session_bounds;
+
+/**
+ * @brief Opens a session on a network file.
+ *
+ * @param filename A DOT file (*.dot) or a snapshot of tn_graph_save_snapshot.
+ * @return tn_session The session, or NULL if the file cannot be loaded (a message is printed on stderr).
+ */
+tn_session tn_session_open(const char *filename);
+
+/**
+ * @brief Opens a session on a graph. The graph is only read during the call.
+ *
+ * @param graph A graph (see TunnelGraph.h).
+ * @return tn_session
+ */
+tn_session tn_session_from_graph(const tn_graph graph);
+
+/**
+ * @brief Opens a session on a TunnelNetwork. The network is only read during the call.
+ *
+ * @param network A TunnelNetwork.
+ * @return tn_session
+ */
+tn_session tn_session_from_network(const TunnelNetwork network);
+
+/**
+ * @brief Closes a session and frees its context and solvers.
+ *
+ * @param session A session.
+ */
+void tn_session_close(tn_session session);
+
+/**
+ * @brief Accessors on the network of the session. The names are owned by the session.
+ */
+int tn_session_num_nodes(const tn_session session);
+int tn_session_initial(const tn_session session);
+int tn_session_final(const tn_session session);
+const char *tn_session_node_name(const tn_session session, int node);
+
+/**
+ * @brief Sets the number of threads building the encoding of each new length (1 by default).
+ *
+ * See tn_view_parallel_reduction_body_copy. The solving itself stays on the calling thread.
+ *
+ * @param session A session.
+ * @param num_threads The number of threads.
+ */
+void tn_session_set_num_threads(tn_session session, int num_threads);
+
+/**
+ * @brief Sets a budget on the size of the reduction (see TunnelEstimate.h), or removes it if @p budget is NULL.
+ *
+ * Before encoding a new length, its size is predicted with tn_view_estimate_reduction. Lengths over the budget
+ * are not encoded: they are answered by the explicit search of tn_view_search_path, in memory linear in the
+ * network, and a note is printed on stderr the first time.
+ *
+ * @param session A session.
+ * @param budget The budget, copied.
+ * @param max_search_steps The bound on the steps of each explicit search, 0 for no bound. A search that reaches
+ * it makes tn_session_solve answer tn_session_unknown.
+ */
+void tn_session_set_budget(tn_session session, const tn_size_estimate *budget, long max_search_steps);
+
+/**
+ * @brief Sets the budget of each query, 0 meaning no limit (the default).
+ *
+ * The budget is shared by all the lengths tried by one call to tn_session_solve: what is left of it is given to
+ * each check through the "timeout" and "max_conflicts" parameters of the solver, and a length is not started once
+ * it is spent. The first query of a length encodes it and loads it in the solver, which is not interrupted: a time
+ * budget can be overrun by that time, which tn_session_set_budget bounds.
+ *
+ * @param session A session.
+ * @param timeout_ms The time of a query, in milliseconds.
+ * @param max_conflicts The conflicts of the solver during a query.
+ */
+void tn_session_set_query_budget(tn_session session, unsigned timeout_ms, unsigned max_conflicts);
+
+/**
+ * @brief Interrupts the query running on @p session, which answers tn_session_unknown. Can be called from
+ * another thread (Z3_interrupt); does nothing if no query is running.
+ *
+ * A query interrupted while it encodes or loads a length stops before its next check. A check already running
+ * is interrupted until it returns, which this function waits for.
+ *
+ * @param session A session.
+ */
+void tn_session_interrupt(tn_session session);
+
+/**
+ * @brief The bounds established by the last query of @p session.
+ *
+ * @param session A session.
+ * @param bounds The bounds.
+ */
+void tn_session_last_bounds(const tn_session session, tn_session_bounds *bounds);
+
+/**
+ * @brief The node named @p name.
+ *
+ * @param session A session.
+ * @param name A node name.
+ * @return int The node, or -1 if there is no such node.
+ */
+int tn_session_find_node(const tn_session session, const char *name);
+
+/**
+ * @brief Looks for a shortest path from @p source to @p target of length at most @p max_length.
+ *
+ * The lengths shorter than the distance from @p source to @p target in the graph are skipped without encoding,
+ * and the query is tn_session_unsat at once if that distance is over @p max_length. A path visits each node at
+ * most once, so @p max_length is clamped to the number of nodes minus one: no longer length is encoded.
+ *
+ * @param session A session.
+ * @param source The first node of the path.
+ * @param target The last node of the path.
+ * @param max_length The maximal length tried.
+ * @param path An array of tn_step of size at least @p max_length, filled if a path is found.
+ * @param length The length of the path found.
+ * @return tn_session_result The path returned is checked with tn_view_check_path; a path rejected by the check is
+ * reported on stderr and the result is tn_session_unknown. So is an encoding stopped by the memory limit of
+ * tn_memory_set_limit, an explicit search stopped by the bound of tn_session_set_budget, or a query over the budget of
+ * tn_session_set_query_budget or interrupted. tn_session_last_bounds then tells what was established.
+ */
+tn_session_result tn_session_solve(tn_session session, int source, int target, int max_length, tn_step *path, int *length);
+
+#endif
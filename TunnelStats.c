@@ -0,0 +1,163 @@
+#include "TunnelStats.h"
+#include "TunnelCommon.h"
+#include "TunnelEncoding.h"
+#include "stdlib.h"
+#include "string.h"
+
+atomic_bool tn_stats_enabled;
+atomic_ulong tn_stats_counters[TN_NUM_COUNTERS];
+
+static const char *counter_names[TN_NUM_COUNTERS] = {"Z3 API calls", "path variables", "4 variables", "6 variables",
+                                                     "model lookups"};
+
+void tn_stats_enable(bool enabled)
+{
+    atomic_store(&tn_stats_enabled, enabled);
+}
+
+void tn_stats_reset(void)
+{
+    for (int c = 0; c < TN_NUM_COUNTERS; c++)
+        atomic_store(&tn_stats_counters[c], 0);
+}
+
+void tn_stats_read(unsigned long counters[TN_NUM_COUNTERS])
+{
+    for (int c = 0; c < TN_NUM_COUNTERS; c++)
+        counters[c] = atomic_load(&tn_stats_counters[c]);
+}
+
+// ===== TAILLE DES FORMULES =====
+
+static bool is_variable(Z3_context ctx, Z3_ast ast)
+{
+    if (Z3_get_ast_kind(ctx, ast) != Z3_APP_AST)
+        return false;
+    Z3_app app = Z3_to_app(ctx, ast);
+    return Z3_get_app_num_args(ctx, app) == 0 && Z3_get_decl_kind(ctx, Z3_get_app_decl(ctx, app)) == Z3_OP_UNINTERPRETED;
+}
+
+static bool is_literal(Z3_context ctx, Z3_ast ast)
+{
+    if (is_variable(ctx, ast))
+        return true;
+    if (Z3_get_ast_kind(ctx, ast) != Z3_APP_AST)
+        return false;
+    Z3_app app = Z3_to_app(ctx, ast);
+    return Z3_get_decl_kind(ctx, Z3_get_app_decl(ctx, app)) == Z3_OP_NOT && is_variable(ctx, Z3_get_app_arg(ctx, app, 0));
+}
+
+// Parcours du DAG : chaque sous-formule partagée n'est comptée qu'une fois, sauf comme conjoint de tête
+void tn_stats_formula_size(Z3_context ctx, Z3_ast formula, tn_formula_size *size)
+{
+    size_t seen_size = 1024;
+    unsigned char *seen = calloc(seen_size, 1);
+    size_t stack_size = 1024;
+    Z3_ast *stack = malloc(stack_size * sizeof(Z3_ast));
+    bool *top_level = malloc(stack_size * sizeof(bool));
+    size_t top = 0;
+    memset(size, 0, sizeof(*size));
+
+    stack[top] = formula;
+    top_level[top++] = true;
+    while (top > 0)
+    {
+        top--;
+        Z3_ast ast = stack[top];
+        bool conjunct = top_level[top];
+        unsigned id = Z3_get_ast_id(ctx, ast);
+        if (id >= seen_size)
+        {
+            size_t new_size = 2 * (size_t)id + 1;
+            seen = realloc(seen, new_size);
+            memset(seen + seen_size, 0, new_size - seen_size);
+            seen_size = new_size;
+        }
+        if (Z3_get_ast_kind(ctx, ast) != Z3_APP_AST)
+            continue;
+        Z3_app app = Z3_to_app(ctx, ast);
+        bool is_and = Z3_get_decl_kind(ctx, Z3_get_app_decl(ctx, app)) == Z3_OP_AND;
+        if (conjunct && !is_and)
+            size->num_clauses++;
+        if (seen[id])
+            continue;
+        seen[id] = 1;
+
+        size->num_ast_nodes++;
+        if (is_variable(ctx, ast))
+            size->num_variables++;
+        unsigned num_args = Z3_get_app_num_args(ctx, app);
+        for (unsigned i = 0; i < num_args; i++)
+        {
+            Z3_ast arg = Z3_get_app_arg(ctx, app, i);
+            if (is_literal(ctx, arg))
+                size->num_literals++;
+            if (top == stack_size)
+            {
+                stack_size *= 2;
+                stack = realloc(stack, stack_size * sizeof(Z3_ast));
+                top_level = realloc(top_level, stack_size * sizeof(bool));
+            }
+            stack[top] = arg;
+            top_level[top++] = conjunct && is_and;
+        }
+    }
+    free(top_level);
+    free(stack);
+    free(seen);
+}
+
+// ===== RAPPORTS =====
+
+void tn_stats_print_counters(FILE *out)
+{
+    unsigned long counters[TN_NUM_COUNTERS];
+    tn_stats_read(counters);
+    for (int c = 0; c < TN_NUM_COUNTERS; c++)
+        fprintf(out, "%-16s %12lu\n", counter_names[c], counters[c]);
+}
+
+void tn_stats_print_reduction(FILE *out, Z3_context ctx, const tn_view view, int length)
+{
+    static const char *part_names[] = {"initial_and_final", "unique_node", "simple_path", "valid_transitions"};
+    bool was_enabled = atomic_load(&tn_stats_enabled);
+    tn_stats_enable(true);
+
+    fprintf(out, "%-18s %10s %10s %10s %10s %10s %12s %10s %10s\n", "sub-formula", "variables", "AST nodes",
+            "clauses", "literals", "build ms", "Z3 calls", "x created", "y created");
+    tn_formula_size total = {0, 0, 0, 0};
+    for (int part = tn_part_initial_and_final; part <= tn_part_valid_transitions; part++)
+    {
+        unsigned long before[TN_NUM_COUNTERS];
+        unsigned long after[TN_NUM_COUNTERS];
+        tn_stats_read(before);
+        double start = tn_now();
+        Z3_ast formula = tn_view_formula_part_copy(ctx, view, (tn_formula_part)part, 0, length);
+        double seconds = tn_now() - start;
+        tn_stats_read(after);
+        if (formula == NULL)
+        {
+            fprintf(out, "%-18s stopped by the memory limit after %.2f ms\n", part_names[part], 1000 * seconds);
+            continue;
+        }
+
+        tn_formula_size size;
+        tn_stats_formula_size(ctx, formula, &size);
+        total.num_variables += size.num_variables;
+        total.num_ast_nodes += size.num_ast_nodes;
+        total.num_clauses += size.num_clauses;
+        total.num_literals += size.num_literals;
+        unsigned long y_created = after[tn_counter_4_variables] - before[tn_counter_4_variables] +
+                                  after[tn_counter_6_variables] - before[tn_counter_6_variables];
+        fprintf(out, "%-18s %10ld %10ld %10ld %10ld %10.2f %12lu %10lu %10lu\n", part_names[part], size.num_variables,
+                size.num_ast_nodes, size.num_clauses, size.num_literals, 1000 * seconds,
+                after[tn_counter_z3_calls] - before[tn_counter_z3_calls],
+                after[tn_counter_path_variables] - before[tn_counter_path_variables], y_created);
+        Z3_dec_ref(ctx, formula);
+    }
+    // Les variables et les nœuds partagés entre sous-formules sont comptés dans chacune
+    fprintf(out, "%-18s %10ld %10ld %10ld %10ld\n", "sum", total.num_variables, total.num_ast_nodes, total.num_clauses,
+            total.num_literals);
+
+    tn_stats_enable(was_enabled);
+}
@@ -0,0 +1,124 @@
+#ifndef TUNNEL_STATS_H
+#define TUNNEL_STATS_H
+
+#include "TunnelView.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <z3.h>
+
+/**
+ * @file TunnelStats.h
+ * @brief Formula statistics and hot-path counters of the encoder and the decoders (-stats).
+ *
+ * The counters are global to the process and shared by all threads. They only move once tn_stats_enable has
+ * been called: when disabled, counting costs a test of a flag.
+ */
+
+/**
+ * @brief The hot-path counters.
+ */
+typedef enum
+{
+    tn_counter_z3_calls,       // calls to the Z3 API made by the encoder (term constructors, reference counts)
+    tn_counter_path_variables, // variables created by tn_path_variable(_copy)
+    tn_counter_4_variables,    // variables created by tn_4_variable(_copy)
+    tn_counter_6_variables,    // variables created by tn_6_variable(_copy)
+    tn_counter_model_lookups,  // variables looked up in a model by the decoders
+    TN_NUM_COUNTERS
+} tn_counter;
+
+extern atomic_bool tn_stats_enabled;
+extern atomic_ulong tn_stats_counters[TN_NUM_COUNTERS];
+
+/**
+ * @brief Adds @p n to a counter if the statistics are enabled.
+ *
+ * @param counter The counter.
+ * @param n The increment.
+ */
+static inline void tn_stats_count(tn_counter counter, unsigned long n)
+{
+    if (atomic_load_explicit(&tn_stats_enabled, memory_order_relaxed))
+        atomic_fetch_add_explicit(&tn_stats_counters[counter], n, memory_order_relaxed);
+}
+
+/*
+ * An encoder file that defines TN_STATS_WRAP_Z3 before including this header gets its calls to the Z3 API and
+ * its model lookups counted. The macros call the function of the same name, which is not expanded again.
+ */
+#ifdef TN_STATS_WRAP_Z3
+#define TN_COUNTED_Z3(call) (tn_stats_count(tn_counter_z3_calls, 1), call)
+#define Z3_mk_not(...) TN_COUNTED_Z3(Z3_mk_not(__VA_ARGS__))
+#define Z3_mk_and(...) TN_COUNTED_Z3(Z3_mk_and(__VA_ARGS__))
+#define Z3_mk_or(...) TN_COUNTED_Z3(Z3_mk_or(__VA_ARGS__))
+#define Z3_mk_implies(...) TN_COUNTED_Z3(Z3_mk_implies(__VA_ARGS__))
+#define Z3_mk_eq(...) TN_COUNTED_Z3(Z3_mk_eq(__VA_ARGS__))
+#define Z3_mk_atmost(...) TN_COUNTED_Z3(Z3_mk_atmost(__VA_ARGS__))
+#define Z3_mk_true(...) TN_COUNTED_Z3(Z3_mk_true(__VA_ARGS__))
+#define Z3_mk_false(...) TN_COUNTED_Z3(Z3_mk_false(__VA_ARGS__))
+#define Z3_inc_ref(...) TN_COUNTED_Z3(Z3_inc_ref(__VA_ARGS__))
+#define Z3_dec_ref(...) TN_COUNTED_Z3(Z3_dec_ref(__VA_ARGS__))
+#define value_of_var_in_model(...) (tn_stats_count(tn_counter_model_lookups, 1), value_of_var_in_model(__VA_ARGS__))
+#endif
+
+/**
+ * @brief Turns the counters on or off.
+ *
+ * @param enabled true to count.
+ */
+void tn_stats_enable(bool enabled);
+
+/**
+ * @brief Sets all the counters to 0.
+ */
+void tn_stats_reset(void);
+
+/**
+ * @brief Reads all the counters.
+ *
+ * @param counters The values, indexed by tn_counter.
+ */
+void tn_stats_read(unsigned long counters[TN_NUM_COUNTERS]);
+
+/**
+ * @brief Size of a formula.
+ */
+typedef struct
+{
+    long num_variables; ///< Distinct propositional variables.
+    long num_ast_nodes; ///< Distinct applications (shared sub-formulas counted once).
+    long num_clauses;   ///< Conjuncts once the top-level conjunctions are flattened.
+    long num_literals;  ///< Arguments that are a variable or its negation, over the distinct sub-formulas.
+} tn_formula_size;
+
+/**
+ * @brief Measures the size of a formula.
+ *
+ * @param ctx The context of the formula.
+ * @param formula A formula.
+ * @param size Its size.
+ */
+void tn_stats_formula_size(Z3_context ctx, Z3_ast formula, tn_formula_size *size);
+
+/**
+ * @brief Prints the hot-path counters.
+ *
+ * @param out The output stream.
+ */
+void tn_stats_print_counters(FILE *out);
+
+/**
+ * @brief Builds each sub-formula of the reduction of @p view (see tn_view_formula_part_copy) and prints its
+ * size, its build time and the counters it moved.
+ *
+ * The counters are enabled during the call and left as they were.
+ *
+ * @param out The output stream.
+ * @param ctx The solver context.
+ * @param view A view of the network.
+ * @param length The length of the sought path.
+ */
+void tn_stats_print_reduction(FILE *out, Z3_context ctx, const tn_view view, int length);
+
+#endif
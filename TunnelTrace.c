@@ -0,0 +1,139 @@
+#include "TunnelTrace.h"
+#include "TunnelCommon.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+static atomic_bool enabled;
+static FILE *trace_file;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static double origin;                 // instant de tn_trace_open, en microsecondes
+static bool first_event;              // pas de virgule avant le premier événement
+static atomic_int num_lanes;
+static _Thread_local int thread_lane; // 0 tant que le thread n'a rien écrit
+
+static double now_us(void)
+{
+    return tn_now() * 1e6;
+}
+
+static int lane(void)
+{
+    if (thread_lane == 0)
+        thread_lane = atomic_fetch_add(&num_lanes, 1) + 1;
+    return thread_lane;
+}
+
+// Séparateur avant un événement ; trace_lock doit être pris
+static void write_separator(void)
+{
+    fprintf(trace_file, first_event ? "\n" : ",\n");
+    first_event = false;
+}
+
+bool tn_trace_open(const char *filename)
+{
+    FILE *file = fopen(filename, "w");
+    if (file == NULL)
+    {
+        perror(filename);
+        return false;
+    }
+    pthread_mutex_lock(&trace_lock);
+    trace_file = file;
+    first_event = true;
+    origin = now_us();
+    fprintf(trace_file, "[");
+    pthread_mutex_unlock(&trace_lock);
+    atomic_store(&enabled, true);
+    return true;
+}
+
+void tn_trace_close(void)
+{
+    atomic_store(&enabled, false);
+    pthread_mutex_lock(&trace_lock);
+    if (trace_file != NULL)
+    {
+        fprintf(trace_file, "\n]\n");
+        fclose(trace_file);
+        trace_file = NULL;
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+void tn_trace_name_thread(const char *name)
+{
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed))
+        return;
+    int tid = lane();
+    pthread_mutex_lock(&trace_lock);
+    if (trace_file != NULL)
+    {
+        write_separator();
+        fprintf(trace_file, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+                tid, name);
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+tn_trace_span tn_trace_begin(const char *name, const char *category)
+{
+    tn_trace_span span = {name, category, -1};
+    if (atomic_load_explicit(&enabled, memory_order_relaxed))
+        span.start = now_us() - origin;
+    return span;
+}
+
+void tn_trace_end(tn_trace_span span)
+{
+    tn_trace_end_args(span, NULL);
+}
+
+void tn_trace_end_args(tn_trace_span span, const char *args)
+{
+    if (span.start < 0 || !atomic_load_explicit(&enabled, memory_order_relaxed))
+        return;
+    double end = now_us() - origin;
+    int tid = lane();
+    pthread_mutex_lock(&trace_lock);
+    if (trace_file != NULL)
+    {
+        write_separator();
+        fprintf(trace_file, "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d",
+                span.name, span.category, span.start, end - span.start, tid);
+        if (args != NULL)
+            fprintf(trace_file, ", \"args\": %s", args);
+        fprintf(trace_file, "}");
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+char *tn_trace_z3_statistics(Z3_context ctx, Z3_solver solver)
+{
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed))
+        return NULL;
+    Z3_stats stats = Z3_solver_get_statistics(ctx, solver);
+    Z3_stats_inc_ref(ctx, stats);
+    unsigned size = Z3_stats_size(ctx, stats);
+
+    size_t capacity = 64 + 96 * (size_t)size;
+    char *json = malloc(capacity);
+    size_t used = snprintf(json, capacity, "{");
+    for (unsigned i = 0; i < size; i++)
+    {
+        const char *key = Z3_stats_get_key(ctx, stats, i);
+        const char *separator = i == 0 ? "" : ", ";
+        if (strlen(key) + 64 > capacity - used)
+            break;
+        if (Z3_stats_is_uint(ctx, stats, i))
+            used += snprintf(json + used, capacity - used, "%s\"%s\": %u", separator, key, Z3_stats_get_uint_value(ctx, stats, i));
+        else
+            used += snprintf(json + used, capacity - used, "%s\"%s\": %g", separator, key, Z3_stats_get_double_value(ctx, stats, i));
+    }
+    snprintf(json + used, capacity - used, "}");
+    Z3_stats_dec_ref(ctx, stats);
+    return json;
+}
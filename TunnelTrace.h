@@ -0,0 +1,79 @@
+#ifndef TUNNEL_TRACE_H
+#define TUNNEL_TRACE_H
+
+#include <stdbool.h>
+#include <z3.h>
+
+/**
+ * @file TunnelTrace.h
+ * @brief Timeline of the solve pipeline in the Chrome trace-event format (chrome://tracing, Perfetto).
+ *
+ * While a trace is open, each span (parse, formula_* builders, solver checks, path extraction, ...) is written
+ * as a complete event of the lane of the thread that ran it; each thread gets its own lane the first time it
+ * records a span. When no trace is open, tn_trace_begin and tn_trace_end only test a flag.
+ */
+
+/**
+ * @brief A running span, from tn_trace_begin to tn_trace_end.
+ */
+typedef struct
+{
+    const char *name;
+    const char *category;
+    double start; // microseconds since tn_trace_open, negative when no trace is open
+} tn_trace_span;
+
+/**
+ * @brief Starts writing a trace.
+ *
+ * @param filename The JSON file of the trace.
+ * @return true on success (a message is printed on stderr otherwise).
+ */
+bool tn_trace_open(const char *filename);
+
+/**
+ * @brief Ends the trace and closes its file. Spans still running are not recorded.
+ */
+void tn_trace_close(void);
+
+/**
+ * @brief Names the lane of the calling thread ("main", "worker 3", ...).
+ *
+ * @param name The name of the lane.
+ */
+void tn_trace_name_thread(const char *name);
+
+/**
+ * @brief Starts a span on the calling thread.
+ *
+ * @param name The name of the span (a string that lives until tn_trace_end, without quotes).
+ * @param category Its category: "parse", "encode", "solve", "decode", ...
+ * @return tn_trace_span The span, to pass to tn_trace_end.
+ */
+tn_trace_span tn_trace_begin(const char *name, const char *category);
+
+/**
+ * @brief Ends a span.
+ *
+ * @param span The span of tn_trace_begin.
+ */
+void tn_trace_end(tn_trace_span span);
+
+/**
+ * @brief Ends a span and attaches arguments to it.
+ *
+ * @param span The span of tn_trace_begin.
+ * @param args A JSON object (such as the one of tn_trace_z3_statistics), or NULL.
+ */
+void tn_trace_end_args(tn_trace_span span, const char *args);
+
+/**
+ * @brief The statistics of a solver as a JSON object, to attach to the span of a check.
+ *
+ * @param ctx The solver context.
+ * @param solver A solver.
+ * @return char* The JSON object, to free, or NULL when no trace is open.
+ */
+char *tn_trace_z3_statistics(Z3_context ctx, Z3_solver solver);
+
+#endif
@@ -0,0 +1,161 @@
+#include "TunnelValidator.h"
+#include "stdlib.h"
+
+// Accès au réseau : un TunnelNetwork ou une vue
+typedef struct
+{
+    bool (*is_edge)(const void *network, int source, int target);
+    bool (*has_action)(const void *network, int node, action act);
+    const void *network;
+} network_access;
+
+static bool network_is_edge(const void *network, int source, int target)
+{
+    return tn_is_edge((const TunnelNetwork)network, source, target);
+}
+
+static bool network_has_action(const void *network, int node, action act)
+{
+    return tn_node_has_action((const TunnelNetwork)network, node, act);
+}
+
+static bool view_is_edge(const void *view, int source, int target)
+{
+    return tn_view_is_edge((const tn_view)view, source, target);
+}
+
+static bool view_has_action(const void *view, int node, action act)
+{
+    return tn_view_node_has_action((const tn_view)view, node, act);
+}
+
+// Effet d'une action sur la pile : sommet avant l'action, variation de hauteur et sommet après l'action
+// (pour un pop, le sommet après l'action est la cellule sous le sommet dépilé)
+typedef struct
+{
+    action act;
+    int delta;
+    int before;
+    int after;
+} stack_action;
+
+static const stack_action stack_actions[] = {
+    {transmit_4, 0, 4, 4},
+    {transmit_6, 0, 6, 6},
+    {push_4_4, 1, 4, 4},
+    {push_4_6, 1, 4, 6},
+    {push_6_4, 1, 6, 4},
+    {push_6_6, 1, 6, 6},
+    {pop_4_4, -1, 4, 4},
+    {pop_4_6, -1, 6, 4},
+    {pop_6_4, -1, 4, 6},
+    {pop_6_6, -1, 6, 6},
+};
+
+#define NUM_STACK_ACTIONS ((int)(sizeof(stack_actions) / sizeof(stack_actions[0])))
+
+static const stack_action *find_action(action act)
+{
+    for (int a = 0; a < NUM_STACK_ACTIONS; a++)
+        if (stack_actions[a].act == act)
+            return &stack_actions[a];
+    return NULL;
+}
+
+// Ensemble de nœuds à adressage ouvert, de taille proportionnelle à la longueur du chemin
+static bool insert_node(int *slots, int num_slots, int node)
+{
+    unsigned i = ((unsigned)node * 2654435761u) & (num_slots - 1);
+    while (slots[i] != -1)
+    {
+        if (slots[i] == node)
+            return false;
+        i = (i + 1) & (num_slots - 1);
+    }
+    slots[i] = node;
+    return true;
+}
+
+static tn_path_check failure(tn_path_error error, int pos)
+{
+    return (tn_path_check){error, pos};
+}
+
+static tn_path_check check_path(network_access access, int source, int target, int length, const tn_step *path)
+{
+    if (length == 0)
+        return source == target ? failure(tn_path_valid, -1) : failure(tn_path_wrong_target, 0);
+    if (path[0].source != source)
+        return failure(tn_path_wrong_source, 0);
+
+    int num_slots = 1;
+    while (num_slots < 2 * (length + 1))
+        num_slots *= 2;
+    int *slots = malloc(num_slots * sizeof(int));
+    for (int i = 0; i < num_slots; i++)
+        slots[i] = -1;
+    int *stack = malloc((length + 2) * sizeof(int));
+    int height = 0;
+    stack[0] = 4;
+    insert_node(slots, num_slots, source);
+
+    tn_path_check result = failure(tn_path_valid, -1);
+    for (int pos = 0; pos < length && result.error == tn_path_valid; pos++)
+    {
+        const tn_step *step = &path[pos];
+        const stack_action *sa = find_action(step->action);
+        if (pos > 0 && step->source != path[pos - 1].target)
+            result = failure(tn_path_disconnected, pos);
+        else if (!access.is_edge(access.network, step->source, step->target))
+            result = failure(tn_path_missing_edge, pos);
+        else if (sa == NULL || !access.has_action(access.network, step->source, step->action))
+            result = failure(tn_path_missing_action, pos);
+        else if (stack[height] != sa->before || (sa->delta < 0 && (height == 0 || stack[height - 1] != sa->after)))
+            result = failure(tn_path_wrong_stack, pos);
+        else if (!insert_node(slots, num_slots, step->target))
+            result = failure(tn_path_repeated_node, pos);
+        else
+        {
+            height += sa->delta;
+            stack[height] = sa->after;
+        }
+    }
+
+    if (result.error == tn_path_valid && path[length - 1].target != target)
+        result = failure(tn_path_wrong_target, length - 1);
+    if (result.error == tn_path_valid && (height != 0 || stack[0] != 4))
+        result = failure(tn_path_wrong_final_stack, length - 1);
+
+    free(stack);
+    free(slots);
+    return result;
+}
+
+tn_path_check tn_check_path(const TunnelNetwork network, int length, const tn_step *path)
+{
+    network_access access = {network_is_edge, network_has_action, network};
+    return check_path(access, tn_get_initial(network), tn_get_final(network), length, path);
+}
+
+tn_path_check tn_view_check_path(const tn_view view, int source, int target, int length, const tn_step *path)
+{
+    network_access access = {view_is_edge, view_has_action, view};
+    return check_path(access, source, target, length, path);
+}
+
+const char *tn_path_error_message(tn_path_error error)
+{
+    switch (error)
+    {
+    case tn_path_valid: return "valid path";
+    case tn_path_wrong_source: return "the path does not start on the initial node";
+    case tn_path_wrong_target: return "the path does not end on the final node";
+    case tn_path_disconnected: return "a step does not start where the previous one ended";
+    case tn_path_missing_edge: return "a step follows no edge";
+    case tn_path_missing_action: return "the action is not available on the node";
+    case tn_path_wrong_stack: return "the action does not apply to the stack";
+    case tn_path_repeated_node: return "a node is visited twice";
+    case tn_path_wrong_final_stack: return "the stack is not [4] at the end";
+    default: return "unknown error";
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef TUNNEL_VALIDATOR_H
+#define TUNNEL_VALIDATOR_H
+
+#include "TunnelNetwork.h"
+#include "TunnelView.h"
+
+/**
+ * @file TunnelValidator.h
+ * @brief Checks a tn_step path against its network by replaying it, independently of the solver.
+ *
+ * The path is replayed step by step: each step must follow an edge of the network and continue where the
+ * previous one ended, its action must be one of the actions of its source node and must apply to the current
+ * stack (transmit a: top a; push a b: top a, b pushed; pop a b: top b over a, b popped). The path must start
+ * on the initial node, end on the final node with the stack [4] again, and visit each node at most once.
+ *
+ * The check runs in O(length) time and memory, whatever the size of the network.
+ */
+
+/**
+ * @brief The first problem found in a path.
+ */
+typedef enum
+{
+    tn_path_valid,
+    tn_path_wrong_source,    ///< The first step does not start on the initial node.
+    tn_path_wrong_target,    ///< The last step does not end on the final node.
+    tn_path_disconnected,    ///< A step does not start where the previous one ended.
+    tn_path_missing_edge,    ///< A step follows no edge of the network.
+    tn_path_missing_action,  ///< The action is not one of the actions of the source node.
+    tn_path_wrong_stack,     ///< The action does not apply to the top of the stack.
+    tn_path_repeated_node,   ///< A node is visited twice.
+    tn_path_wrong_final_stack ///< The stack is not [4] at the end.
+} tn_path_error;
+
+/**
+ * @brief Result of a check: the problem found and the position of the step where it was found (-1 if valid).
+ */
+typedef struct
+{
+    tn_path_error error;
+    int pos;
+} tn_path_check;
+
+/**
+ * @brief Checks a path of a TunnelNetwork.
+ *
+ * @param network A TunnelNetwork.
+ * @param length The length of the path.
+ * @param path The steps of the path.
+ * @return tn_path_check
+ */
+tn_path_check tn_check_path(const TunnelNetwork network, int length, const tn_step *path);
+
+/**
+ * @brief Same as tn_check_path, for a path between two given nodes of a view.
+ *
+ * @param view A view of the network.
+ * @param source The expected first node.
+ * @param target The expected last node.
+ * @param length The length of the path.
+ * @param path The steps of the path.
+ * @return tn_path_check
+ */
+tn_path_check tn_view_check_path(const tn_view view, int source, int target, int length, const tn_step *path);
+
+/**
+ * @brief A short description of an error, for messages.
+ *
+ * @param error An error.
+ * @return const char* A static string.
+ */
+const char *tn_path_error_message(tn_path_error error);
+
+#endif
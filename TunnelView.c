@@ -0,0 +1,178 @@
+#include "TunnelView.h"
+#include "TunnelCommon.h"
+#include "TunnelMemory.h"
+#include "stdint.h"
+#include "stdlib.h"
+#include "string.h"
+
+struct tn_view_s
+{
+    int num_nodes;
+    int num_edges;
+    int initial;
+    int final;
+    unsigned *actions;
+    int *offsets; // CSR : successeurs de u = targets[offsets[u] .. offsets[u + 1] - 1], triés
+    int *targets;
+    uint64_t *bits; // matrice d'adjacence, ligne u = bits[u * words .. (u + 1) * words - 1] (NULL si creux)
+    int words;
+};
+
+// Taille des tableaux de la vue, pour TunnelMemory
+static long view_memory(const tn_view view)
+{
+    size_t bits = view->bits == NULL ? 0 : ((size_t)view->num_nodes * view->words + 1) * sizeof(uint64_t);
+    return (long)(sizeof(struct tn_view_s) + (2 * (size_t)view->num_nodes + 1 + view->num_edges) * sizeof(int) + bits);
+}
+
+static tn_view view_create(int num_nodes, int num_edges)
+{
+    tn_view view = malloc(sizeof(struct tn_view_s));
+    view->num_nodes = num_nodes;
+    view->num_edges = num_edges;
+    view->actions = calloc(num_nodes > 0 ? num_nodes : 1, sizeof(unsigned));
+    view->offsets = calloc(num_nodes + 1, sizeof(int));
+    view->targets = malloc((num_edges > 0 ? num_edges : 1) * sizeof(int));
+    view->bits = NULL;
+    view->words = (num_nodes + 63) / 64;
+    return view;
+}
+
+// La matrice n'est gardée que si elle ne dépasse pas deux fois la taille du CSR
+static void build_bitset(tn_view view)
+{
+    size_t n = view->num_nodes;
+    if (n * n > 64 * (n + view->num_edges))
+        return;
+    view->bits = calloc(n * view->words + 1, sizeof(uint64_t));
+    for (int u = 0; u < view->num_nodes; u++)
+        for (int e = view->offsets[u]; e < view->offsets[u + 1]; e++)
+        {
+            int v = view->targets[e];
+            view->bits[(size_t)u * view->words + (v >> 6)] |= (uint64_t)1 << (v & 63);
+        }
+}
+
+tn_view tn_view_from_network(const TunnelNetwork network)
+{
+    int num_nodes = tn_get_num_nodes(network);
+
+    // Une seule passe sur tn_is_edge : les successeurs sont ajoutés dans l'ordre, donc déjà triés
+    int max_edges = num_nodes > 0 ? num_nodes : 1;
+    int *targets = malloc(max_edges * sizeof(int));
+    int *offsets = malloc((num_nodes + 1) * sizeof(int));
+    int num_edges = 0;
+    for (int u = 0; u < num_nodes; u++)
+    {
+        offsets[u] = num_edges;
+        for (int v = 0; v < num_nodes; v++)
+        {
+            if (!tn_is_edge(network, u, v))
+                continue;
+            if (num_edges == max_edges)
+            {
+                max_edges *= 2;
+                targets = realloc(targets, max_edges * sizeof(int));
+            }
+            targets[num_edges++] = v;
+        }
+    }
+    offsets[num_nodes] = num_edges;
+
+    tn_view view = view_create(num_nodes, num_edges);
+    view->initial = tn_get_initial(network);
+    view->final = tn_get_final(network);
+    memcpy(view->offsets, offsets, (num_nodes + 1) * sizeof(int));
+    memcpy(view->targets, targets, num_edges * sizeof(int));
+    free(offsets);
+    free(targets);
+
+    for (int u = 0; u < num_nodes; u++)
+        for (int a = 0; a < TN_NUM_ACTIONS; a++)
+            if (tn_node_has_action(network, u, tn_all_actions[a]))
+                view->actions[u] |= tn_graph_action_bit(tn_all_actions[a]);
+
+    build_bitset(view);
+    tn_memory_track(view_memory(view));
+    return view;
+}
+
+tn_view tn_view_from_graph(const tn_graph graph)
+{
+    int num_nodes = tn_graph_num_nodes(graph);
+    tn_view view = view_create(num_nodes, tn_graph_num_edges(graph));
+    view->initial = tn_graph_initial(graph);
+    view->final = tn_graph_final(graph);
+
+    for (int u = 0; u < num_nodes; u++)
+    {
+        int num_successors;
+        const int *successors = tn_graph_successors(graph, u, &num_successors);
+        view->offsets[u + 1] = view->offsets[u] + num_successors;
+        memcpy(view->targets + view->offsets[u], successors, num_successors * sizeof(int));
+        view->actions[u] = tn_graph_node_actions(graph, u);
+    }
+
+    build_bitset(view);
+    tn_memory_track(view_memory(view));
+    return view;
+}
+
+void tn_view_delete(tn_view view)
+{
+    tn_memory_track(-view_memory(view));
+    free(view->bits);
+    free(view->targets);
+    free(view->offsets);
+    free(view->actions);
+    free(view);
+}
+
+int tn_view_num_nodes(const tn_view view)
+{
+    return view->num_nodes;
+}
+
+int tn_view_initial(const tn_view view)
+{
+    return view->initial;
+}
+
+int tn_view_final(const tn_view view)
+{
+    return view->final;
+}
+
+unsigned tn_view_node_actions(const tn_view view, int node)
+{
+    return view->actions[node];
+}
+
+bool tn_view_node_has_action(const tn_view view, int node, action act)
+{
+    return (view->actions[node] & tn_graph_action_bit(act)) != 0;
+}
+
+bool tn_view_is_edge(const tn_view view, int source, int target)
+{
+    if (view->bits != NULL)
+        return (view->bits[(size_t)source * view->words + (target >> 6)] >> (target & 63)) & 1;
+
+    int low = view->offsets[source];
+    int high = view->offsets[source + 1];
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (view->targets[middle] < target)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low < view->offsets[source + 1] && view->targets[low] == target;
+}
+
+const int *tn_view_successors(const tn_view view, int node, int *num_successors)
+{
+    *num_successors = view->offsets[node + 1] - view->offsets[node];
+    return view->targets + view->offsets[node];
+}
@@ -0,0 +1,66 @@
+#ifndef TUNNEL_VIEW_H
+#define TUNNEL_VIEW_H
+
+#include "TunnelGraph.h"
+#include "TunnelNetwork.h"
+#include <stdbool.h>
+
+/**
+ * @file TunnelView.h
+ * @brief Read-only view of a network used by the encoder, built once per reduction.
+ *
+ * The successors of each node are stored in CSR form, sorted, and the actions of each node in a packed mask
+ * (bit tn_graph_action_bit(a) for the action a). When the graph is dense enough, the view also keeps an
+ * adjacency bitset so that tn_view_is_edge is a single load and shift; otherwise it is a binary search in the
+ * sorted successors.
+ *
+ * The view can be built from a TunnelNetwork or from a tn_graph (DOT loader or snapshot), so the encoder does
+ * not depend on how the network is stored.
+ */
+
+typedef struct tn_view_s *tn_view;
+
+/**
+ * @brief Builds the view of a TunnelNetwork (one pass over tn_is_edge and tn_node_has_action).
+ *
+ * @param network A TunnelNetwork.
+ * @return tn_view The view, to free with tn_view_delete.
+ */
+tn_view tn_view_from_network(const TunnelNetwork network);
+
+/**
+ * @brief Builds the view of a tn_graph. The graph is copied, it can be deleted before the view.
+ *
+ * @param graph A graph.
+ * @return tn_view The view, to free with tn_view_delete.
+ */
+tn_view tn_view_from_graph(const tn_graph graph);
+
+/**
+ * @brief Frees a view.
+ *
+ * @param view A view.
+ */
+void tn_view_delete(tn_view view);
+
+/**
+ * @brief Accessors. The masks and the successor arrays are owned by the view.
+ */
+int tn_view_num_nodes(const tn_view view);
+int tn_view_initial(const tn_view view);
+int tn_view_final(const tn_view view);
+unsigned tn_view_node_actions(const tn_view view, int node);
+bool tn_view_node_has_action(const tn_view view, int node, action act);
+bool tn_view_is_edge(const tn_view view, int source, int target);
+
+/**
+ * @brief The successors of @p node, sorted.
+ *
+ * @param view A view.
+ * @param node A node.
+ * @param num_successors The number of successors.
+ * @return const int* The successors, valid as long as the view.
+ */
+const int *tn_view_successors(const tn_view view, int node, int *num_successors);
+
+#endif